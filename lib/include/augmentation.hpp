@@ -0,0 +1,116 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// monoid augmentation of order statistic nodes: range sums, minimums, maximums
+
+#pragma once
+
+#include "tree_node.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace red
+{
+namespace containers
+{
+
+// An augmentation is a monoid over the elements of a set, every node keeps the aggregate of its
+// subtree next to its size. Augment_t provides
+//     result_type                 - the aggregate
+//     identity ()                 - aggregate of no elements
+//     of (value)                  - aggregate of a single element
+//     combine (lhs, rhs)          - aggregate of lhs followed by rhs, must be associative
+// The elements are combined in the set order, so combine need not be commutative.
+template <typename T, class Augment_t> struct augmented_node : public dynamic_order_set_node<T>
+{
+    using base = dynamic_order_set_node<T>;
+    using typename base::base_node_ptr;
+    using typename base::value_type;
+    using aggregate_type = typename Augment_t::result_type;
+    using augment_type   = Augment_t;
+
+    aggregate_type m_aggregate;
+
+    template <typename... Args>
+    augmented_node (std::in_place_t tag, Args &&...args)
+        : base {tag, std::forward<Args> (args)...}, m_aggregate {Augment_t::of (this->m_value)}
+    {
+    }
+
+    static aggregate_type aggregate (base_node_ptr node)
+    {
+        return (node ? static_cast<augmented_node *> (node)->m_aggregate : Augment_t::identity ());
+    }
+
+    static aggregate_type of (base_node_ptr node)
+    {
+        return Augment_t::of (static_cast<augmented_node *> (node)->m_value);
+    }
+
+    static void update (base_node_ptr node)
+    {
+        base::update (node);
+        static_cast<augmented_node *> (node)->m_aggregate = Augment_t::combine (
+            Augment_t::combine (aggregate (node->m_left), of (node)), aggregate (node->m_right));
+    }
+
+    // new_top takes the place of old_top, so it inherits its size and aggregate.
+    static void after_rotate (base_node_ptr old_top, base_node_ptr new_top)
+    {
+        base::size_ref (new_top) = base::size_ref (old_top);
+        static_cast<augmented_node *> (new_top)->m_aggregate =
+            static_cast<augmented_node *> (old_top)->m_aggregate;
+        update (old_top);
+    }
+};
+
+// Ready-made augmentations. Proj_t picks what is aggregated out of an element, e.g. a weight
+// attached to the key.
+template <typename T, class Proj_t = std::identity> struct sum_augment
+{
+    using result_type = std::remove_cvref_t<std::invoke_result_t<Proj_t, const T &>>;
+
+    static result_type identity () { return result_type {}; }
+    static result_type of (const T &value) { return Proj_t {}(value); }
+    static result_type combine (const result_type &lhs, const result_type &rhs)
+    {
+        return lhs + rhs;
+    }
+};
+
+template <typename T, class Proj_t = std::identity> struct min_augment
+{
+    using result_type = std::remove_cvref_t<std::invoke_result_t<Proj_t, const T &>>;
+
+    static result_type identity () { return std::numeric_limits<result_type>::max (); }
+    static result_type of (const T &value) { return Proj_t {}(value); }
+    static result_type combine (const result_type &lhs, const result_type &rhs)
+    {
+        return std::min (lhs, rhs);
+    }
+};
+
+template <typename T, class Proj_t = std::identity> struct max_augment
+{
+    using result_type = std::remove_cvref_t<std::invoke_result_t<Proj_t, const T &>>;
+
+    static result_type identity () { return std::numeric_limits<result_type>::lowest (); }
+    static result_type of (const T &value) { return Proj_t {}(value); }
+    static result_type combine (const result_type &lhs, const result_type &rhs)
+    {
+        return std::max (lhs, rhs);
+    }
+};
+
+}   // namespace containers
+}   // namespace red
@@ -0,0 +1,358 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// order statistic sets with worst-case or expected O(log n) balancing: treap, AVL, red-black
+
+#pragma once
+
+#include "dynamic_order_set.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace red
+{
+namespace containers
+{
+
+// The balancing engine lives in the node type, next to the size maintenance it extends. Besides
+// after_rotate and update every node provides
+//     after_build (root)    - sets the balancing data of a perfectly balanced tree, called by
+//                             base_set::build_balanced
+//     after_insert (node)   - rebalances after node is linked in as a leaf
+//     after_erase (removed, parent, child)
+//                           - rebalances after removed, which had at most one child, is replaced
+//                             by that child under parent. parent is the header if removed was
+//                             the root.
+// Rotations go through the header above the root like everywhere else, so a node is the root
+// when its parent has no parent.
+
+inline bool is_root (const dl_binary_tree_node_base *node) { return !node->m_parent->m_parent; }
+
+// Treap: a max-heap on random priorities, which keeps the expected depth O(log n).
+template <typename T> struct treap_node : public dynamic_order_set_node<T>
+{
+    using base = dynamic_order_set_node<T>;
+    using typename base::base_node_ptr;
+    using typename base::value_type;
+
+    std::uint32_t m_priority = next_priority ();
+
+    template <typename... Args>
+    treap_node (std::in_place_t tag, Args &&...args) : base {tag, std::forward<Args> (args)...}
+    {
+    }
+
+    static std::uint32_t next_priority ()
+    {
+        // xorshift32, every thread has its own sequence
+        thread_local std::uint32_t state = 0x2545f491;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    static std::uint32_t priority (base_node_ptr node)
+    {
+        return static_cast<treap_node *> (node)->m_priority;
+    }
+
+    // the shape is already balanced, fresh priorities are dealt out in level order, largest first
+    static void after_build (base_node_ptr root)
+    {
+        std::vector<base_node_ptr> levels {root};
+        for ( std::size_t i = 0; i < levels.size (); ++i )
+        {
+            if ( levels[i]->m_left )
+                levels.push_back (levels[i]->m_left);
+            if ( levels[i]->m_right )
+                levels.push_back (levels[i]->m_right);
+        }
+        std::vector<std::uint32_t> priorities (levels.size ());
+        std::generate (priorities.begin (), priorities.end (), next_priority);
+        std::sort (priorities.begin (), priorities.end (), std::greater<> {});
+        for ( std::size_t i = 0; i < levels.size (); ++i )
+            static_cast<treap_node *> (levels[i])->m_priority = priorities[i];
+    }
+
+    static void after_insert (base_node_ptr node)
+    {
+        while ( !is_root (node) && priority (node) > priority (node->m_parent) )
+            node->template rotate_to_parent<treap_node> ();
+    }
+
+    // the child had a lower priority than removed, so it fits under parent as well
+    static void after_erase (base_node_ptr, base_node_ptr, base_node_ptr) {}
+};
+
+// AVL tree: subtree heights differ by at most one, depth is below 1.45 log2 (n).
+template <typename T> struct avl_node : public dynamic_order_set_node<T>
+{
+    using base = dynamic_order_set_node<T>;
+    using typename base::base_node_ptr;
+    using typename base::value_type;
+
+    int m_height = 1;
+
+    template <typename... Args>
+    avl_node (std::in_place_t tag, Args &&...args) : base {tag, std::forward<Args> (args)...}
+    {
+    }
+
+    static int height (base_node_ptr node)
+    {
+        return (node ? static_cast<avl_node *> (node)->m_height : 0);
+    }
+
+    static int balance (base_node_ptr node)
+    {
+        return height (node->m_left) - height (node->m_right);
+    }
+
+    static void update (base_node_ptr node)
+    {
+        base::update (node);
+        static_cast<avl_node *> (node)->m_height =
+            1 + std::max (height (node->m_left), height (node->m_right));
+    }
+
+    static void after_rotate (base_node_ptr old_top, base_node_ptr new_top)
+    {
+        update (old_top);
+        update (new_top);
+    }
+
+    // build_subtree has already set the heights through update ()
+    static void after_build (base_node_ptr) {}
+
+    // Restores heights and balance from node up to the root. Sizes are already right, rotations
+    // keep them so.
+    static void rebalance_up (base_node_ptr node)
+    {
+        for ( ; node->m_parent; node = node->m_parent )
+        {
+            update (node);
+            if ( balance (node) > 1 )
+            {
+                if ( balance (node->m_left) < 0 )
+                    node->m_left->template rotate_left<avl_node> ();
+                node = node->template rotate_right<avl_node> ();
+            }
+            else if ( balance (node) < -1 )
+            {
+                if ( balance (node->m_right) > 0 )
+                    node->m_right->template rotate_right<avl_node> ();
+                node = node->template rotate_left<avl_node> ();
+            }
+        }
+    }
+
+    static void after_insert (base_node_ptr node) { rebalance_up (node); }
+
+    static void after_erase (base_node_ptr, base_node_ptr parent, base_node_ptr)
+    {
+        rebalance_up (parent);
+    }
+};
+
+// Red-black tree (CLRS): no red node has a red child and every path from a node down to a leaf
+// passes the same number of black nodes, depth is below 2 log2 (n + 1).
+template <typename T> struct rb_node : public dynamic_order_set_node<T>
+{
+    using base = dynamic_order_set_node<T>;
+    using typename base::base_node_ptr;
+    using typename base::value_type;
+
+    bool m_red = true;
+
+    template <typename... Args>
+    rb_node (std::in_place_t tag, Args &&...args) : base {tag, std::forward<Args> (args)...}
+    {
+    }
+
+    static bool is_red (base_node_ptr node)
+    {
+        return node && static_cast<rb_node *> (node)->m_red;
+    }
+
+    static void set_red (base_node_ptr node, bool red)
+    {
+        static_cast<rb_node *> (node)->m_red = red;
+    }
+
+    // All leaves of a perfectly balanced tree are on the last two levels. The last level is
+    // made red and everything above it black.
+    static void after_build (base_node_ptr root)
+    {
+        auto last_level = static_cast<int> (std::bit_width (base::size (root))) - 1;
+        color_levels (root, 0, last_level);
+    }
+
+    static void color_levels (base_node_ptr node, int depth, int last_level)
+    {
+        if ( !node )
+            return;
+        set_red (node, depth == last_level && depth);
+        color_levels (node->m_left, depth + 1, last_level);
+        color_levels (node->m_right, depth + 1, last_level);
+    }
+
+    static void after_insert (base_node_ptr node)
+    {
+        while ( !is_root (node) && is_red (node->m_parent) )
+        {
+            // a red parent is not the root, so the grandparent is a real node
+            auto parent      = node->m_parent;
+            auto grandparent = parent->m_parent;
+            bool parent_left = (parent == grandparent->m_left);
+            auto uncle       = (parent_left ? grandparent->m_right : grandparent->m_left);
+            if ( is_red (uncle) )
+            {
+                set_red (parent, false);
+                set_red (uncle, false);
+                set_red (grandparent, true);
+                node = grandparent;
+                continue;
+            }
+            if ( parent_left != node->is_left_child () )
+            {
+                node->template rotate_to_parent<rb_node> ();
+                parent = node;
+            }
+            set_red (parent, false);
+            set_red (grandparent, true);
+            parent->template rotate_to_parent<rb_node> ();
+            break;
+        }
+        while ( !is_root (node) )
+            node = node->m_parent;
+        set_red (node, false);
+    }
+
+    static void after_erase (base_node_ptr removed, base_node_ptr parent, base_node_ptr child)
+    {
+        if ( is_red (removed) )
+            return;
+        // A removed black node leaves the path through child one black short. The loop stops at
+        // the header, and the short side always has a sibling: the other side carries at least
+        // one black node.
+        auto node = child;
+        bool left = (child ? child->is_left_child () : !parent->m_left);
+        while ( parent->m_parent && !is_red (node) )
+        {
+            auto sibling = (left ? parent->m_right : parent->m_left);
+            if ( is_red (sibling) )
+            {
+                set_red (sibling, false);
+                set_red (parent, true);
+                sibling->template rotate_to_parent<rb_node> ();
+                sibling = (left ? parent->m_right : parent->m_left);
+            }
+            auto near = (left ? sibling->m_left : sibling->m_right);
+            auto far  = (left ? sibling->m_right : sibling->m_left);
+            if ( !is_red (near) && !is_red (far) )
+            {
+                set_red (sibling, true);
+                node   = parent;
+                parent = node->m_parent;
+                left   = node->is_left_child ();
+                continue;
+            }
+            if ( !is_red (far) )
+            {
+                set_red (near, false);
+                set_red (sibling, true);
+                near->template rotate_to_parent<rb_node> ();
+                far     = sibling;
+                sibling = near;
+            }
+            set_red (sibling, is_red (parent));
+            set_red (parent, false);
+            set_red (far, false);
+            sibling->template rotate_to_parent<rb_node> ();
+            return;
+        }
+        if ( node )
+            set_red (node, false);
+    }
+};
+
+// The dynamic_order_set interface on a balanced tree, Node_t selects the engine. Lookups and
+// order statistic queries are those of dynamic_order_set, only updates are rebalanced.
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>,
+          class Node_t = rb_node<T>>
+struct balanced_order_set : public dynamic_order_set<T, Compare_t, Alloc_t, Node_t>
+{
+  private:
+    using base_do_set = dynamic_order_set<T, Compare_t, Alloc_t, Node_t>;
+    using base_set    = typename base_do_set::base;
+    using typename base_do_set::base_node_ptr;
+    using typename base_do_set::node;
+    using typename base_do_set::node_ptr;
+
+  public:
+    using typename base_do_set::size_type;
+    using typename base_do_set::value_type;
+
+    template <typename K> using key_arg = typename base_do_set::template key_arg<K>;
+
+    using typename base_do_set::const_iterator;
+    using typename base_do_set::const_reverse_iterator;
+    using typename base_do_set::iterator;
+    using typename base_do_set::reverse_iterator;
+
+    using base_do_set::base_do_set;
+
+    void insert (const value_type &key) { emplace (key); }
+
+    void insert (value_type &&key) { emplace (std::move (key)); }
+
+    template <typename... Args> void emplace (Args &&...args)
+    {
+        auto inserted = base_set::emplace_value (
+            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size++; },
+            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; },
+            std::forward<Args> (args)...);
+        node::after_insert (inserted);
+    }
+
+    template <typename K = value_type> void erase (const key_arg<K> &key)
+    {
+        erase_node (base_set::find_for_erase (key, [] (base_node_ptr) {}, [] (base_node_ptr) {}));
+    }
+
+    void erase (iterator it) { erase_node (it.m_node); }
+
+  private:
+    void erase_node (base_node_ptr to_erase)
+    {
+        auto [parent, child] = base_do_set::unlink_node (to_erase);
+        node::after_erase (to_erase, parent, child);
+        base_set::destroy_node (to_erase);
+        base_set::decr_size ();
+    }
+};
+
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>>
+using treap_order_set = balanced_order_set<T, Compare_t, Alloc_t, treap_node<T>>;
+
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>>
+using avl_order_set = balanced_order_set<T, Compare_t, Alloc_t, avl_node<T>>;
+
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>>
+using rb_order_set = balanced_order_set<T, Compare_t, Alloc_t, rb_node<T>>;
+
+}   // namespace containers
+}   // namespace red
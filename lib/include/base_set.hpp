@@ -11,127 +11,217 @@
 
 #pragma once
 
+#include "node_arena.hpp"
 #include "tree_node.hpp"
+#include "tree_stats.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <compare>
+#include <concepts>
 #include <cstddef>
 #include <fstream>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
 #include <tuple>
-#include <unordered_set>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace red
 {
 namespace containers
 {
 
+// 1 for std::less and -1 for std::greater, whose order the built-in operator<=> reproduces, 0 for
+// any other comparator
+template <class Compare> inline constexpr int std_order_direction = 0;
+template <typename U> inline constexpr int std_order_direction<std::less<U>> = 1;
+template <typename U> inline constexpr int std_order_direction<std::greater<U>> = -1;
+
 // helper type offering value initialization guarantee on the compare functor.
+// Compare is either a "less" predicate or a three-way comparator returning one of the
+// std::*_ordering types, like std::compare_three_way. A descent may ask for a three-way result
+// and take one comparison per level where a predicate needs two.
 template <class Compare> struct key_compare
 {
     Compare m_value_compare;
 
     key_compare (const Compare &comp) : m_value_compare (comp) {}
 
-    template <typename Key> bool operator() (const Key &k1, const Key &k2) const
+    template <typename Key1, typename Key2>
+    static constexpr bool user_three_way = requires (const Compare &comp, const Key1 &k1,
+                                                     const Key2 &k2) {
+        { comp (k1, k2) } -> std::convertible_to<std::partial_ordering>;
+    };
+
+    // pointers are left to std::less, which orders them totally while <=> need not
+    template <typename Key1, typename Key2>
+    static constexpr bool builtin_three_way =
+        std_order_direction<Compare> != 0 && std::three_way_comparable_with<Key1, Key2> &&
+        !std::is_pointer_v<Key1> && !std::is_pointer_v<Key2>;
+
+    template <typename Key1, typename Key2>
+    static constexpr bool has_three_way =
+        user_three_way<Key1, Key2> || builtin_three_way<Key1, Key2>;
+
+    template <typename Key1, typename Key2> bool operator() (const Key1 &k1, const Key2 &k2) const
     {
-        return m_value_compare (k1, k2);
+        if constexpr ( user_three_way<Key1, Key2> )
+            return m_value_compare (k1, k2) < 0;
+        else
+            return m_value_compare (k1, k2);
     }
+
+    // -1, 0 or 1 as k1 goes before, together with or after k2, requires has_three_way
+    template <typename Key1, typename Key2> int three_way (const Key1 &k1, const Key2 &k2) const
+    {
+        std::partial_ordering order = std::partial_ordering::equivalent;
+        if constexpr ( user_three_way<Key1, Key2> )
+            order = m_value_compare (k1, k2);
+        else if constexpr ( std_order_direction<Compare> > 0 )
+            order = k1 <=> k2;
+        else
+            order = k2 <=> k1;
+        return (order < 0 ? -1 : (order > 0 ? 1 : 0));
+    }
+};
+
+template <class Compare>
+inline constexpr bool is_transparent_v = requires { typename Compare::is_transparent; };
+
+// Key type of a lookup: whatever the argument is if the comparator is transparent, value_type
+// otherwise. The member alias resolves to K itself in the first case, so K is deduced from the
+// argument, while in the second one K is not deducible and defaults to value_type, keeping the
+// usual conversions of the argument.
+template <bool Transparent> struct lookup_key
+{
+    template <typename K, typename T> using type = T;
+};
+
+template <> struct lookup_key<true>
+{
+    template <typename K, typename T> using type = K;
 };
 
 // helper type to manage deafault initialization of node count, header and boundary nodes.
-// stores all tree's nodes as unique pointers.
+// tree nodes are owned by the tree itself: every node is reachable from the header, so erase
+// frees its node directly and the set tears the tree down in one walk. The header node lives
+// inside the struct, so moving a set allocates nothing and leaves the source a valid empty set.
 struct header
 {
     using base_node     = dl_binary_tree_node_base;
     using base_node_ptr = dl_binary_tree_node_base *;
 
-    struct unique_node_ptr_hash
-    {
-        std::size_t operator() (const std::unique_ptr<base_node> &unique_ptr) const
-        {
-            return reinterpret_cast<std::size_t> (unique_ptr.get ());
-        }
-    };
-
-    struct unique_node_ptr_equal
-    {
-        bool operator() (const std::unique_ptr<base_node> &lhs,
-                         const std::unique_ptr<base_node> &rhs) const
-        {
-            return lhs.get () == rhs.get ();
-        }
-    };
-
-    base_node_ptr m_header    = nullptr;
+    // parent of the root, the root is its left child
+    mutable base_node m_node;
     base_node_ptr m_leftmost  = nullptr;
     base_node_ptr m_rightmost = nullptr;
-    std::unordered_set<std::unique_ptr<base_node>, unique_node_ptr_hash, unique_node_ptr_equal>
-        m_nodes;
     std::size_t m_size {0};
 
-    header ()
+    header () = default;
+
+    header (const header &) = delete;
+    header &operator= (const header &) = delete;
+
+    header (header &&rhs) noexcept
+        : m_leftmost {rhs.m_leftmost}, m_rightmost {rhs.m_rightmost}, m_size {rhs.m_size}
     {
-        auto node = std::make_unique<base_node> ();
-        m_header  = node.get ();
-        m_nodes.emplace (std::move (node));
+        adopt_root (rhs.m_node.m_left);
+        rhs.m_reset ();
     }
 
-    // Inserts to_insert into m_nodes. Performs check that to_insert has not already been inserted
-    // (Otherwise releases to_insert to avoid double free and throws an exeption).
-    void insert_node (std::unique_ptr<base_node> &&to_insert)
+    header &operator= (header &&rhs) noexcept
     {
-        if ( m_nodes.count (to_insert) )
-        {
-            to_insert.release ();
-            throw std::runtime_error ("double insert of the node");
-        }
-        m_nodes.emplace (std::move (to_insert));
+        auto root = m_node.m_left;
+        adopt_root (rhs.m_node.m_left);
+        rhs.adopt_root (root);
+        std::swap (m_leftmost, rhs.m_leftmost);
+        std::swap (m_rightmost, rhs.m_rightmost);
+        std::swap (m_size, rhs.m_size);
+        return *this;
     }
 
+    base_node_ptr node () const { return &m_node; }
+
+    // forgets about the nodes, they have to be freed by the owner beforehand.
     void m_reset ()
     {
-        m_leftmost  = nullptr;
-        m_rightmost = nullptr;
-        m_header    = nullptr;
-        m_size      = 0;
-        m_nodes.clear ();
-        auto node = std::make_unique<base_node> ();
-        m_header  = node.get ();
-        m_nodes.emplace (std::move (node));
+        m_node.m_left = nullptr;
+        m_leftmost    = nullptr;
+        m_rightmost   = nullptr;
+        m_size        = 0;
+    }
+
+  private:
+    void adopt_root (base_node_ptr root)
+    {
+        m_node.m_left = root;
+        if ( root )
+            root->m_parent = &m_node;
     }
 };
 
 // basic set itself
-template <typename T, class Compare_t = std::less<T>> struct base_set
+// Alloc_t is rebound to Node_t, every node of the set is allocated through it.
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>,
+          class Node_t = set_node<T>>
+struct base_set
 {
   protected:
     using key_compare_t = key_compare<Compare_t>;
-    using self          = base_set<T, Compare_t>;
+    using self          = base_set<T, Compare_t, Alloc_t, Node_t>;
 
-    using base_node     = dl_binary_tree_node_base;
-    using base_node_ptr = base_node *;
-    using node          = set_node<T>;
-    using node_ptr      = node *;
+    using base_node      = dl_binary_tree_node_base;
+    using base_node_ptr  = base_node *;
+    using node           = Node_t;
+    using node_ptr       = node *;
     using const_node_ptr = const node *;
 
+    using node_allocator_t = typename std::allocator_traits<Alloc_t>::template rebind_alloc<node>;
+    using node_alloc_traits = std::allocator_traits<node_allocator_t>;
+
   public:
-    using size_type  = typename std::size_t;
-    using value_type = T;
+    using size_type      = typename std::size_t;
+    using value_type     = T;
+    using allocator_type = Alloc_t;
+
+    // argument type of the lookups, see lookup_key
+    template <typename K>
+    using key_arg = typename lookup_key<is_transparent_v<Compare_t>>::template type<K, T>;
 
   private:
     key_compare_t m_compare_struct;
     header m_header_struct;
+    node_allocator_t m_node_alloc;
+    [[no_unique_address]] stats_counters<stats_enabled> m_stats;
 
   public:
     base_set () : m_compare_struct {Compare_t {}} {}
     base_set (const Compare_t &comp) : m_compare_struct {comp} {}
+    base_set (const Compare_t &comp, const Alloc_t &alloc)
+        : m_compare_struct {comp}, m_node_alloc {alloc}
+    {
+    }
 
-    base_set (const self &rhs) : m_compare_struct {rhs.m_compare_struct}
+    template <std::input_iterator It>
+    base_set (It first, It last, const Compare_t &comp = Compare_t {}) : m_compare_struct {comp}
     {
-        for ( auto &elem : rhs )
-            insert (elem);
+        assign (first, last);
+    }
+
+    base_set (std::initializer_list<value_type> ilist, const Compare_t &comp = Compare_t {})
+        : base_set (ilist.begin (), ilist.end (), comp)
+    {
+    }
+
+    base_set (const self &rhs)
+        : m_compare_struct {rhs.m_compare_struct},
+          m_node_alloc {node_alloc_traits::select_on_container_copy_construction (rhs.m_node_alloc)}
+    {
+        copy_tree (rhs);
     }
 
     self &operator= (const self &rhs)
@@ -141,20 +231,24 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
         return *this;
     }
 
-    base_set (self &&rhs) noexcept : m_compare_struct {Compare_t {}}
+    // Takes the nodes without allocating anything, rhs is left an empty set with its comparator
+    // and allocator.
+    base_set (self &&rhs) noexcept
+        : m_compare_struct {rhs.m_compare_struct},
+          m_header_struct {std::move (rhs.m_header_struct)},
+          m_node_alloc {std::move (rhs.m_node_alloc)}
     {
-        std::swap (m_compare_struct, rhs.m_compare_struct);
-        std::swap (m_header_struct, rhs.m_header_struct);
     }
 
     self &operator= (self &&rhs) noexcept
     {
         std::swap (m_compare_struct, rhs.m_compare_struct);
         std::swap (m_header_struct, rhs.m_header_struct);
+        std::swap (m_node_alloc, rhs.m_node_alloc);
         return *this;
     }
 
-    virtual ~base_set () {}
+    ~base_set () { destroy_tree (); }
 
     template <typename TT> struct set_iterator
     {
@@ -242,27 +336,74 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
 
     // modifiers
 
-    void clear () { m_header_struct.m_reset (); }
+    void clear () { reset_header_struct (); }
+
+    // Replaces the contents with the keys from [first, last), which must not point into this set.
+    // Duplicates are dropped. A strictly increasing forward range is consumed as is, anything else
+    // is sorted in a buffer first. The tree is then built perfectly balanced in O(n).
+    template <std::input_iterator It> void assign (It first, It last)
+    {
+        auto less = [this] (const value_type &lhs, const value_type &rhs) {
+            return compare (lhs, rhs);
+        };
+        if constexpr ( std::forward_iterator<It> )
+        {
+            if ( std::adjacent_find (first, last, std::not_fn (less)) == last )
+            {
+                build_balanced (first, std::distance (first, last));
+                return;
+            }
+        }
+        std::vector<value_type> keys (first, last);
+        std::sort (keys.begin (), keys.end (), less);
+        auto unique_end = std::unique (keys.begin (), keys.end (),
+                                       [&less] (const value_type &lhs, const value_type &rhs) {
+                                           return !less (lhs, rhs);
+                                       });
+        build_balanced (std::make_move_iterator (keys.begin ()),
+                        std::distance (keys.begin (), unique_end));
+    }
+
+    void assign (std::initializer_list<value_type> ilist) { assign (ilist.begin (), ilist.end ()); }
+
+    // Preallocates storage for n elements when the allocator supports it.
+    void reserve (size_type n)
+    {
+        if constexpr ( requires (node_allocator_t alloc) { alloc.reserve (n); } )
+        {
+            if ( n > size () )
+                m_node_alloc.reserve (n - size ());
+        }
+    }
+
+    allocator_type get_allocator () const { return allocator_type {m_node_alloc}; }
 
-    virtual void insert (const value_type &key)
+    // Snapshot of the work done since construction or the last reset_stats (). All zeros unless
+    // the library is built with SPLAY_TREE_STATS.
+    tree_stats stats () const { return m_stats.get (); }
+
+    void reset_stats () { m_stats.reset (); }
+
+    void insert (const value_type &key) { emplace (key); }
+
+    void insert (value_type &&key) { emplace (std::move (key)); }
+
+    // constructs the element in the new node, which is freed again if the key is already there
+    template <typename... Args> void emplace (Args &&...args)
     {
-        auto to_insert_uptr = std::make_unique<node> (key);
-        auto to_insert      = to_insert_uptr.get ();
-        insert_node_to_nodes (std::move (to_insert_uptr));
-        insert_base (
-            to_insert, [] (base_node_ptr) {}, [] (base_node_ptr) {});
+        emplace_value ([] (base_node_ptr) {}, [] (base_node_ptr) {}, std::forward<Args> (args)...);
     }
 
-    virtual void erase (const value_type &key)
+    template <typename K = value_type> void erase (const key_arg<K> &key)
     {
         auto to_erase = find_for_erase (
             key, [] (base_node_ptr) {}, [] (base_node_ptr) {});
         erase_base (to_erase);
     }
 
-    virtual void erase (iterator it) { erase_base (it.m_node); }
+    void erase (iterator it) { erase_base (it.m_node); }
 
-    virtual const_iterator find (const value_type key) const
+    template <typename K = value_type> const_iterator find (const key_arg<K> &key) const
     {
         auto [found, prev, prev_greater] = trav_bin_search (key, [] (base_node_ptr) {});
         if ( !found )
@@ -270,7 +411,7 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
         return const_iterator {static_cast<node_ptr> (found), this};
     }
 
-    virtual iterator find (const value_type key)
+    template <typename K = value_type> iterator find (const key_arg<K> &key)
     {
         auto [found, prev, prev_greater] = trav_bin_search (key, [] (base_node_ptr) {});
         if ( !found )
@@ -278,13 +419,13 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
         return iterator {static_cast<node_ptr> (found), this};
     }
 
-    virtual iterator lower_bound (const value_type &val) const
+    template <typename K = value_type> iterator lower_bound (const key_arg<K> &val) const
     {
         auto res = lower_bound_base (val);
         return iterator {static_cast<node_ptr> (res), this};
     }
 
-    virtual iterator upper_bound (const value_type &val) const
+    template <typename K = value_type> iterator upper_bound (const key_arg<K> &val) const
     {
         auto res = upper_bound_base (val);
         return iterator {static_cast<node_ptr> (res), this};
@@ -296,27 +437,259 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
     }
 
   protected:
-    void insert_node_to_nodes (std::unique_ptr<base_node> &&node_uptr)
+    void reset_header_struct ()
     {
-        m_header_struct.insert_node (std::move (node_uptr));
+        destroy_tree ();
+        m_header_struct.m_reset ();
     }
 
-    void reset_header_struct () { m_header_struct.m_reset (); }
-
     void inc_size () { ++m_header_struct.m_size; }
 
     void decr_size () { --m_header_struct.m_size; }
 
-    void erase_node_from_nodes (base_node_ptr to_erase)
+    void set_size (size_type size) { m_header_struct.m_size = size; }
+
+    // Makes the subtree the whole tree of this set, which must be empty.
+    void attach_tree (base_node_ptr root, base_node_ptr leftmost, base_node_ptr rightmost,
+                      size_type size)
     {
-        std::erase_if (m_header_struct.m_nodes, [&] (const std::unique_ptr<base_node> &uptr) {
-            return uptr.get () == to_erase;
-        });
+        assert (empty ());
+        this->root ()               = root;
+        root->m_parent              = m_header_struct.node ();
+        m_header_struct.m_leftmost  = leftmost;
+        m_header_struct.m_rightmost = rightmost;
+        m_header_struct.m_size      = size;
     }
 
-    bool compare (const value_type &lhs, const value_type &rhs) const
+    // Leaves the set empty without freeing the nodes, they must have been handed over to
+    // another owner.
+    void forget_tree () { m_header_struct.m_reset (); }
+
+    // Gives this empty set the comparator and the node storage of other, so that subtrees can
+    // move between the two sets as they are.
+    void share_storage (const self &other)
     {
-        return m_compare_struct.m_value_compare (lhs, rhs);
+        assert (empty ());
+        m_compare_struct = other.m_compare_struct;
+        m_node_alloc     = other.m_node_alloc;
+    }
+
+    // Makes the nodes of other freeable through the allocator of this set, so that they can be
+    // moved over without copying. Fails if the allocators differ and this one cannot take over
+    // the memory of the other one.
+    bool adopt_storage (self &other)
+    {
+        if constexpr ( node_alloc_traits::is_always_equal::value )
+            return true;
+        else
+        {
+            if ( m_node_alloc == other.m_node_alloc )
+                return true;
+            if constexpr ( requires (node_allocator_t alloc) { alloc.adopt (alloc); } )
+                return m_node_alloc.adopt (other.m_node_alloc);
+            return false;
+        }
+    }
+
+    void count (stat what, size_type n = 1) const { m_stats.add (what, n); }
+
+    template <typename... Args> node_ptr create_node (Args &&...args)
+    {
+        auto to_create = node_alloc_traits::allocate (m_node_alloc, 1);
+        count (stat::allocations);
+        try
+        {
+            node_alloc_traits::construct (m_node_alloc, to_create, std::forward<Args> (args)...);
+        }
+        catch ( ... )
+        {
+            node_alloc_traits::deallocate (m_node_alloc, to_create, 1);
+            throw;
+        }
+        return to_create;
+    }
+
+    // to_erase must already be unlinked from the tree.
+    void destroy_node (base_node_ptr to_erase)
+    {
+        auto to_destroy = static_cast<node_ptr> (to_erase);
+        node_alloc_traits::destroy (m_node_alloc, to_destroy);
+        node_alloc_traits::deallocate (m_node_alloc, to_destroy, 1);
+        count (stat::deallocations);
+    }
+
+    // Frees every node of the subtree in O(n) without recursion or extra memory: left children
+    // are rotated up until the current node has none, so even a degenerate splay tree is safe.
+    void destroy_subtree (base_node_ptr node)
+    {
+        while ( node )
+        {
+            if ( auto left = node->m_left )
+            {
+                node->m_left  = left->m_right;
+                left->m_right = node;
+                node          = left;
+            }
+            else
+            {
+                auto right = node->m_right;
+                destroy_node (node);
+                node = right;
+            }
+        }
+    }
+
+    // Frees all the nodes. An arena that is not shared with anybody else is released at once
+    // when there are no destructors to run.
+    void destroy_tree ()
+    {
+        if constexpr ( std::is_trivially_destructible_v<node> &&
+                       requires (node_allocator_t alloc) { alloc.release (); } )
+        {
+            if ( m_node_alloc.exclusive () )
+            {
+                count (stat::deallocations, size ());
+                m_node_alloc.release ();
+                return;
+            }
+        }
+        destroy_subtree (root ());
+    }
+
+    // creates a node with the value constructed from args and inserts it, the node is freed
+    // again if insertion fails.
+    template <typename F1, typename F2, typename... Args>
+    base_node_ptr emplace_value (F1 step, F2 step_if_already, Args &&...args)
+    {
+        auto to_insert = create_node (std::in_place, std::forward<Args> (args)...);
+        try
+        {
+            insert_base (to_insert, step, step_if_already);
+        }
+        catch ( ... )
+        {
+            destroy_node (to_insert);
+            throw;
+        }
+        return to_insert;
+    }
+
+    // builds the tree from n sorted unique keys starting at first.
+    template <typename It> void build_balanced (It first, std::ptrdiff_t n)
+    {
+        clear ();
+        reserve (n);
+        if ( !n )
+            return;
+        root ()                     = build_subtree (first, n);
+        root ()->m_parent           = m_header_struct.node ();
+        m_header_struct.m_leftmost  = root ()->minimum ();
+        m_header_struct.m_rightmost = root ()->maximum ();
+        m_header_struct.m_size      = n;
+        // balancing data that update () cannot compute bottom-up, e.g. colors or priorities
+        if constexpr ( requires { node::after_build (root ()); } )
+            node::after_build (root ());
+    }
+
+    // Builds a perfectly balanced subtree of the next n keys taken in order. Recursion depth is
+    // log(n). Returns the root of the subtree, its parent link is left to the caller.
+    template <typename It> base_node_ptr build_subtree (It &curr, std::ptrdiff_t n)
+    {
+        if ( !n )
+            return nullptr;
+        auto left = build_subtree (curr, n / 2);
+        base_node_ptr subtree_root {};
+        try
+        {
+            subtree_root         = create_node (std::in_place, *curr);
+            subtree_root->m_left = left;
+            if ( left )
+                left->m_parent = subtree_root;
+            ++curr;
+            auto right            = build_subtree (curr, n - n / 2 - 1);
+            subtree_root->m_right = right;
+            if ( right )
+                right->m_parent = subtree_root;
+        }
+        catch ( ... )
+        {
+            destroy_subtree (subtree_root ? subtree_root : left);
+            throw;
+        }
+        node::update (subtree_root);
+        return subtree_root;
+    }
+
+    // Copies the structure of rhs node by node, so augmented data is copied as is. Walks the
+    // tree using parent links to stay iterative.
+    void copy_tree (const self &rhs)
+    {
+        auto src = rhs.root ();
+        if ( !src )
+            return;
+
+        auto clone = [this] (base_node_ptr from, base_node_ptr parent) {
+            base_node_ptr res = create_node (*static_cast<node_ptr> (from));
+            res->m_parent     = parent;
+            res->m_left       = nullptr;
+            res->m_right      = nullptr;
+            return res;
+        };
+
+        auto dst = root () = clone (src, m_header_struct.node ());
+        try
+        {
+            while ( true )
+            {
+                if ( src->m_left && !dst->m_left )
+                {
+                    dst->m_left = clone (src->m_left, dst);
+                    src         = src->m_left;
+                    dst         = dst->m_left;
+                }
+                else if ( src->m_right && !dst->m_right )
+                {
+                    dst->m_right = clone (src->m_right, dst);
+                    src          = src->m_right;
+                    dst          = dst->m_right;
+                }
+                else if ( src == rhs.root () )
+                    break;
+                else
+                {
+                    src = src->m_parent;
+                    dst = dst->m_parent;
+                }
+            }
+        }
+        catch ( ... )
+        {
+            reset_header_struct ();
+            throw;
+        }
+        m_header_struct.m_leftmost  = root ()->minimum ();
+        m_header_struct.m_rightmost = root ()->maximum ();
+        m_header_struct.m_size      = rhs.size ();
+    }
+
+    // either side may be a lookup key of a transparent comparator
+    template <typename L, typename R> bool compare (const L &lhs, const R &rhs) const
+    {
+        count (stat::comparisons);
+        return m_compare_struct (lhs, rhs);
+    }
+
+    // -1, 0 or 1 as lhs goes before, together with or after rhs. One comparison if the
+    // comparator or the keys support a three-way one, otherwise one or two calls of Compare_t.
+    template <typename L, typename R> int compare_three_way (const L &lhs, const R &rhs) const
+    {
+        if constexpr ( key_compare_t::template has_three_way<L, R> )
+        {
+            count (stat::comparisons);
+            return m_compare_struct.three_way (lhs, rhs);
+        }
+        else
+            return compare (lhs, rhs) ? -1 : (compare (rhs, lhs) ? 1 : 0);
     }
 
     base_node_ptr &leftmost () { return m_header_struct.m_leftmost; }
@@ -327,7 +700,7 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
 
     base_node_ptr rightmost () const { return m_header_struct.m_rightmost; }
 
-    base_node_ptr &root () const { return m_header_struct.m_header->m_left; }
+    base_node_ptr &root () const { return m_header_struct.node ()->m_left; }
 
     template <typename F1, typename F2>
     base_node_ptr insert_base (base_node_ptr to_insert, F1 step, F2 step_if_already)
@@ -339,9 +712,9 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
 
     void erase_base (base_node_ptr to_erase)
     {
-        auto target = update_bounds_for_erase (to_erase, [] (base_node_ptr) {});
-        evict_node_for_erase (target);
-        erase_node_from_nodes (target);
+        update_bounds_for_erase (to_erase, [] (base_node_ptr) {});
+        evict_node_for_erase (to_erase);
+        destroy_node (to_erase);
         --m_header_struct.m_size;
     }
 
@@ -352,43 +725,87 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
     template <typename F1, typename F2>
     base_node_ptr insert_node_base (base_node_ptr to_insert, F1 step, F2 step_if_already);
 
+    // Hangs the leaf to_insert under prev, the last node of a failed trav_bin_search, on the
+    // side it tells. prev is nullptr if the tree is empty. The size is left to the caller.
+    base_node_ptr link_leaf (base_node_ptr to_insert, base_node_ptr prev, bool prev_greater);
+
     // find node to be erased from the tree
     // "step" applies to every node on the path to the requested key
     // "step_if_no" applies to all nodes on the path to the requested key if there were no
     // element with the requested key
-    template <typename F1, typename F2>
-    base_node_ptr find_for_erase (const value_type &key, F1 step, F2 step_if_no)
+    template <typename K, typename F1, typename F2>
+    base_node_ptr find_for_erase (const K &key, F1 step, F2 step_if_no)
     {
         auto [found, prev, prev_greater] = trav_bin_search (key, step);
         if ( found )
             return found;
-        trav_bin_search (key, step_if_no);
+        step_up (prev, step_if_no);
         throw std::out_of_range ("No element with requested key to erase");
     }
 
-    // update bounds if we erase bounding value
+    // Applies step to node and to each of its ancestors up to the root, the way back of a
+    // descent that ended in node. Undoing the steps of a failed descent this way costs no
+    // comparisons, so the steps must not depend on the order they are applied in.
+    template <typename F> void step_up (base_node_ptr node, F step) const
+    {
+        for ( ; node; node = (node == root () ? nullptr : node->m_parent) )
+            step (node);
+    }
+
+    // Moves to_erase to a place with at most one child and updates the bounds of the set. A node
+    // with two children swaps places with its successor, so iterators to other elements stay
+    // valid. Returns to_erase.
     // "step" applies to every node on the path to the successor or predecessor.
     template <typename F> base_node_ptr update_bounds_for_erase (base_node_ptr to_erase, F step)
     {
-        base_node_ptr target = nullptr;
-        if ( m_header_struct.m_leftmost == to_erase )
+        if ( !to_erase->m_left || !to_erase->m_right )
         {
-            m_header_struct.m_leftmost = to_erase->successor_step (step);
+            if ( m_header_struct.m_leftmost == to_erase )
+                m_header_struct.m_leftmost = to_erase->successor_step (step);
+            if ( m_header_struct.m_rightmost == to_erase )
+                m_header_struct.m_rightmost = to_erase->predecessor_step (step);
             return to_erase;
         }
-        if ( m_header_struct.m_rightmost == to_erase )
+        // neither of them is a bound: the successor is the rightmost only if it is the single
+        // node of the right subtree, and then it stays the rightmost in its new place
+        swap_places (to_erase, to_erase->m_right->minimum (step));
+        return to_erase;
+    }
+
+    // Exchanges the places of a node with two children and its successor in the tree. The data
+    // a node keeps about its place (subtree size, balancing data) goes with the place, the values
+    // and what node::swap_values counts as theirs stay with the nodes.
+    static void swap_places (base_node_ptr node, base_node_ptr succ)
+    {
+        std::swap (*static_cast<node_ptr> (node), *static_cast<node_ptr> (succ));
+        node::swap_values (*static_cast<node_ptr> (node), *static_cast<node_ptr> (succ));
+        std::swap (*node, *succ);
+
+        auto parent     = node->m_parent;
+        bool left       = node->is_left_child ();
+        auto succ_right = succ->m_right;
+
+        if ( succ == node->m_right )
+        {
+            succ->m_right  = node;
+            node->m_parent = succ;
+        }
+        else
         {
-            m_header_struct.m_rightmost = to_erase->predecessor_step (step);
-            return to_erase;
+            succ->m_parent->m_left  = node;
+            node->m_parent          = succ->m_parent;
+            succ->m_right           = node->m_right;
+            succ->m_right->m_parent = succ;
         }
-        target = to_erase->successor_step (step);
-        std::swap (static_cast<node_ptr> (target)->m_value,
-                   static_cast<node_ptr> (to_erase)->m_value);
-        if ( target == m_header_struct.m_leftmost )
-            m_header_struct.m_leftmost = to_erase;
-        if ( target == m_header_struct.m_rightmost )
-            m_header_struct.m_rightmost = to_erase;
-        return target;
+        succ->m_left           = node->m_left;
+        succ->m_left->m_parent = succ;
+        succ->m_parent         = parent;
+        (left ? parent->m_left : parent->m_right) = succ;
+
+        node->m_left  = nullptr;
+        node->m_right = succ_right;
+        if ( succ_right )
+            succ_right->m_parent = node;
     }
 
     void evict_node_for_erase (base_node_ptr target)
@@ -402,14 +819,20 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
             target->m_parent->m_right = child;
     }
 
-    base_node_ptr lower_bound_base (const value_type &val) const
+    template <typename K> base_node_ptr lower_bound_base (const K &val) const
+    {
+        return lower_bound_base (val, [] (base_node_ptr) {});
+    }
+
+    // "step" applies to every node on the path
+    template <typename K, typename F> base_node_ptr lower_bound_base (const K &val, F step) const
     {
         base_node_ptr node   = root ();
         base_node_ptr parent = nullptr;
         while ( node )
         {
-            bool key_bigger =
-                m_compare_struct.m_value_compare (static_cast<node_ptr> (node)->m_value, val);
+            step (node);
+            bool key_bigger = compare (static_cast<node_ptr> (node)->m_value, val);
             if ( !key_bigger )
             {
                 parent = node;
@@ -421,14 +844,20 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
         return parent;
     }
 
-    base_node_ptr upper_bound_base (const value_type &val) const
+    template <typename K> base_node_ptr upper_bound_base (const K &val) const
+    {
+        return upper_bound_base (val, [] (base_node_ptr) {});
+    }
+
+    // "step" applies to every node on the path
+    template <typename K, typename F> base_node_ptr upper_bound_base (const K &val, F step) const
     {
         base_node_ptr node   = root ();
         base_node_ptr parent = nullptr;
         while ( node )
         {
-            bool key_less =
-                m_compare_struct.m_value_compare (val, static_cast<node_ptr> (node)->m_value);
+            step (node);
+            bool key_less = compare (val, static_cast<node_ptr> (node)->m_value);
             if ( key_less )
             {
                 parent = node;
@@ -440,11 +869,11 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
         return parent;
     }
 
-    template <typename F>
-    std::tuple<base_node_ptr, base_node_ptr, bool> trav_bin_search (value_type key, F step) const;
+    template <typename K, typename F>
+    std::tuple<base_node_ptr, base_node_ptr, bool> trav_bin_search (const K &key, F step) const;
 
   public:
-    virtual void dump (std::ostream &stream) const
+    void dump (std::ostream &stream) const
     {
         assert (stream);
         stream << "digraph {\nrankdir = TB\n";
@@ -483,23 +912,25 @@ template <typename T, class Compare_t = std::less<T>> struct base_set
     }
 };
 
-template <typename T, typename Compare_t>
-bool operator== (const base_set<T, Compare_t> &lhs, const base_set<T, Compare_t> &rhs)
+template <typename T, typename Compare_t, typename Alloc_t, typename Node_t>
+bool operator== (const base_set<T, Compare_t, Alloc_t, Node_t> &lhs,
+                 const base_set<T, Compare_t, Alloc_t, Node_t> &rhs)
 {
     return lhs.equal (rhs);
 }
 
-template <typename T, typename Compare_t>
-bool operator!= (const base_set<T, Compare_t> &lhs, const base_set<T, Compare_t> &rhs)
+template <typename T, typename Compare_t, typename Alloc_t, typename Node_t>
+bool operator!= (const base_set<T, Compare_t, Alloc_t, Node_t> &lhs,
+                 const base_set<T, Compare_t, Alloc_t, Node_t> &rhs)
 {
     return !(lhs == rhs);
 }
 
-template <typename Node_t, typename Comp_t>
-template <typename F>
-std::tuple<typename base_set<Node_t, Comp_t>::base_node_ptr,
-           typename base_set<Node_t, Comp_t>::base_node_ptr, bool>
-base_set<Node_t, Comp_t>::trav_bin_search (value_type key, F step) const
+template <typename T, typename Comp_t, typename Alloc_t, typename Node_t>
+template <typename K, typename F>
+std::tuple<typename base_set<T, Comp_t, Alloc_t, Node_t>::base_node_ptr,
+           typename base_set<T, Comp_t, Alloc_t, Node_t>::base_node_ptr, bool>
+base_set<T, Comp_t, Alloc_t, Node_t>::trav_bin_search (const K &key, F step) const
 {
     using res = typename std::tuple<base_node_ptr, base_node_ptr, bool>;
 
@@ -510,10 +941,13 @@ base_set<Node_t, Comp_t>::trav_bin_search (value_type key, F step) const
 
     bool key_less {};
 
-    while ( curr && static_cast<node_ptr> (curr)->m_value != key )
+    // equality is equivalence under the comparator, the key need not have operator==
+    while ( curr )
     {
-        key_less =
-            self::m_compare_struct.m_value_compare (key, static_cast<node_ptr> (curr)->m_value);
+        auto order = self::compare_three_way (key, static_cast<node_ptr> (curr)->m_value);
+        if ( !order )
+            break;
+        key_less = (order < 0);
         step (curr);
         prev = curr;
         if ( key_less )
@@ -528,43 +962,54 @@ base_set<Node_t, Comp_t>::trav_bin_search (value_type key, F step) const
     return res {curr, prev, key_less};
 }
 
-template <typename Node_t, typename Comp_t>
+template <typename T, typename Comp_t, typename Alloc_t, typename Node_t>
 template <typename F1, typename F2>
-typename base_set<Node_t, Comp_t>::base_node_ptr
-base_set<Node_t, Comp_t>::insert_node_base (base_node_ptr to_insert, F1 step, F2 step_if_already)
+typename base_set<T, Comp_t, Alloc_t, Node_t>::base_node_ptr
+base_set<T, Comp_t, Alloc_t, Node_t>::insert_node_base (base_node_ptr to_insert, F1 step,
+                                                       F2 step_if_already)
 {
-    auto to_insert_ptr = to_insert;
     if ( empty () )
-    {
-        m_header_struct.m_header->m_left = std::move (to_insert);
-        to_insert_ptr->m_parent          = m_header_struct.m_header;
-        m_header_struct.m_leftmost       = to_insert_ptr;
-        m_header_struct.m_rightmost      = to_insert_ptr;
-        return to_insert_ptr;
-    }
+        return link_leaf (to_insert, nullptr, false);
     /* Find right position in the tree */
     auto [found, prev, prev_greater] =
-        trav_bin_search (static_cast<node_ptr> (to_insert_ptr)->m_value, step);
+        trav_bin_search (static_cast<node_ptr> (to_insert)->m_value, step);
 
     if ( found )
     {
-        trav_bin_search (static_cast<node_ptr> (to_insert_ptr)->m_value, step_if_already);
+        // the descent stepped through the ancestors of found, or through found if it is the root
+        step_up (found == root () ? found : found->m_parent, step_if_already);
         throw std::out_of_range ("Element already inserted");
     }
+    return link_leaf (to_insert, prev, prev_greater);
+}
+
+template <typename T, typename Comp_t, typename Alloc_t, typename Node_t>
+typename base_set<T, Comp_t, Alloc_t, Node_t>::base_node_ptr
+base_set<T, Comp_t, Alloc_t, Node_t>::link_leaf (base_node_ptr to_insert, base_node_ptr prev,
+                                                bool prev_greater)
+{
+    if ( !prev )
+    {
+        m_header_struct.node ()->m_left = to_insert;
+        to_insert->m_parent             = m_header_struct.node ();
+        m_header_struct.m_leftmost      = to_insert;
+        m_header_struct.m_rightmost     = to_insert;
+        return to_insert;
+    }
     to_insert->m_parent = prev;
-    if ( prev == m_header_struct.m_header || prev_greater )
+    if ( prev == m_header_struct.node () || prev_greater )
     {
-        prev->m_left = std::move (to_insert);
+        prev->m_left = to_insert;
         if ( prev == m_header_struct.m_leftmost )
-            m_header_struct.m_leftmost = to_insert_ptr;
+            m_header_struct.m_leftmost = to_insert;
     }
     else
     {
-        prev->m_right = std::move (to_insert);
+        prev->m_right = to_insert;
         if ( prev == m_header_struct.m_rightmost )
-            m_header_struct.m_rightmost = to_insert_ptr;
+            m_header_struct.m_rightmost = to_insert;
     }
-    return to_insert_ptr;
+    return to_insert;
 }
 }   // namespace containers
 }   // namespace red
\ No newline at end of file
@@ -0,0 +1,651 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// splay set with dynamic ordering stored in contiguous arrays with 32-bit links
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace red
+{
+namespace containers
+{
+
+using compact_index_t = std::uint32_t;
+
+// links of a node in a compact tree. Index 0 is reserved for the nil node whose size is 0.
+struct compact_links
+{
+    compact_index_t m_parent = 0;
+    compact_index_t m_left   = 0;
+    compact_index_t m_right  = 0;
+    compact_index_t m_size   = 0;
+};
+
+// node storage: keys and links either live in two separate arrays (so descents touching only
+// the links stay dense) or interleaved in one.
+template <typename T, bool Split_keys> class compact_storage;
+
+template <typename T> class compact_storage<T, true>
+{
+    std::vector<T> m_keys;
+    std::vector<compact_links> m_links;
+
+  public:
+    T &key (compact_index_t idx) { return m_keys[idx]; }
+    const T &key (compact_index_t idx) const { return m_keys[idx]; }
+
+    compact_links &links (compact_index_t idx) { return m_links[idx]; }
+    const compact_links &links (compact_index_t idx) const { return m_links[idx]; }
+
+    std::size_t size () const { return m_links.size (); }
+
+    void reserve (std::size_t n)
+    {
+        m_keys.reserve (n);
+        m_links.reserve (n);
+    }
+
+    compact_index_t push_back (const T &key)
+    {
+        m_keys.push_back (key);
+        m_links.push_back ({});
+        return static_cast<compact_index_t> (m_links.size () - 1);
+    }
+
+    void clear ()
+    {
+        m_keys.clear ();
+        m_links.clear ();
+    }
+};
+
+template <typename T> class compact_storage<T, false>
+{
+    struct entry
+    {
+        compact_links m_links;
+        T m_key;
+    };
+
+    std::vector<entry> m_entries;
+
+  public:
+    T &key (compact_index_t idx) { return m_entries[idx].m_key; }
+    const T &key (compact_index_t idx) const { return m_entries[idx].m_key; }
+
+    compact_links &links (compact_index_t idx) { return m_entries[idx].m_links; }
+    const compact_links &links (compact_index_t idx) const { return m_entries[idx].m_links; }
+
+    std::size_t size () const { return m_entries.size (); }
+
+    void reserve (std::size_t n) { m_entries.reserve (n); }
+
+    compact_index_t push_back (const T &key)
+    {
+        m_entries.push_back ({{}, key});
+        return static_cast<compact_index_t> (m_entries.size () - 1);
+    }
+
+    void clear () { m_entries.clear (); }
+};
+
+// Order statistic splay set with the same interface as splay_dynamic_order_set, but nodes are
+// addressed by 32-bit indices into contiguous storage. For int keys a node takes 20 bytes.
+// Erased slots are recycled through a free list threaded over m_right. Keys of erased
+// elements are kept in their slots until they are reused or the set is cleared.
+template <typename T, class Compare_t = std::less<T>, bool Split_keys = true>
+struct compact_splay_order_set
+{
+  private:
+    using self    = compact_splay_order_set<T, Compare_t, Split_keys>;
+    using index_t = compact_index_t;
+
+    static constexpr index_t nil = 0;
+
+  public:
+    using value_type = T;
+    using size_type  = typename std::size_t;
+
+  private:
+    Compare_t m_compare;
+    mutable compact_storage<T, Split_keys> m_storage;
+    mutable index_t m_root = nil;
+    index_t m_leftmost     = nil;
+    index_t m_rightmost    = nil;
+    index_t m_free         = nil;
+
+  public:
+    compact_splay_order_set () : compact_splay_order_set {Compare_t {}} {}
+    compact_splay_order_set (const Compare_t &comp) : m_compare {comp}
+    {
+        m_storage.push_back (T {});
+    }
+
+    template <std::input_iterator It>
+    compact_splay_order_set (It first, It last, const Compare_t &comp = Compare_t {})
+        : compact_splay_order_set {comp}
+    {
+        assign (first, last);
+    }
+
+    compact_splay_order_set (std::initializer_list<value_type> ilist,
+                             const Compare_t &comp = Compare_t {})
+        : compact_splay_order_set (ilist.begin (), ilist.end (), comp)
+    {
+    }
+
+    struct const_iterator
+    {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = const T;
+        using pointer           = value_type *;
+        using reference         = value_type &;
+
+        reference operator* () const { return m_tree->m_storage.key (m_idx); }
+
+        pointer operator->() const { return &**this; }
+
+        const_iterator &operator++ ()
+        {
+            m_idx = m_tree->successor (m_idx);
+            return *this;
+        }
+
+        const_iterator operator++ (int)
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        const_iterator &operator-- ()
+        {
+            m_idx = (m_idx ? m_tree->predecessor (m_idx) : m_tree->m_rightmost);
+            return *this;
+        }
+
+        const_iterator operator-- (int)
+        {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        bool operator== (const const_iterator &other) const { return m_idx == other.m_idx; }
+
+        bool operator!= (const const_iterator &other) const { return !(*this == other); }
+
+        index_t m_idx      = nil;
+        const self *m_tree = nullptr;
+    };
+
+    // keys are immutable, so there is no need in a mutable iterator
+    using iterator = const_iterator;
+
+    const_iterator begin () const { return {m_leftmost, this}; }
+
+    const_iterator end () const { return {nil, this}; }
+
+    size_type size () const { return links (m_root).m_size; }
+
+    bool empty () const { return !size (); }
+
+    void reserve (size_type n) { m_storage.reserve (n + 1); }
+
+    void clear ()
+    {
+        m_storage.clear ();
+        m_storage.push_back (T {});
+        m_root = m_leftmost = m_rightmost = m_free = nil;
+    }
+
+    // Replaces the contents with the keys from [first, last), duplicates are dropped. Sorted keys
+    // are laid out in order, so the balanced tree built over them has in-order indices.
+    template <std::input_iterator It> void assign (It first, It last)
+    {
+        auto less = [this] (const value_type &lhs, const value_type &rhs) {
+            return compare (lhs, rhs);
+        };
+        std::vector<value_type> keys (first, last);
+        if ( std::adjacent_find (keys.begin (), keys.end (), std::not_fn (less)) != keys.end () )
+        {
+            std::sort (keys.begin (), keys.end (), less);
+            keys.erase (std::unique (keys.begin (), keys.end (),
+                                     [&less] (const value_type &lhs, const value_type &rhs) {
+                                         return !less (lhs, rhs);
+                                     }),
+                        keys.end ());
+        }
+        if ( keys.size () > std::numeric_limits<index_t>::max () )
+            throw std::length_error ("compact_splay_order_set is full");
+
+        clear ();
+        reserve (keys.size ());
+        for ( const auto &key : keys )
+            m_storage.push_back (key);
+        if ( keys.empty () )
+            return;
+        m_root      = build_subtree (1, static_cast<index_t> (keys.size ()));
+        m_leftmost  = 1;
+        m_rightmost = static_cast<index_t> (keys.size ());
+    }
+
+    void assign (std::initializer_list<value_type> ilist) { assign (ilist.begin (), ilist.end ()); }
+
+    void insert (const value_type &key)
+    {
+        if ( !m_free && m_storage.size () > std::numeric_limits<index_t>::max () )
+            throw std::length_error ("compact_splay_order_set is full");
+        if ( empty () )
+        {
+            m_root = m_leftmost = m_rightmost = create_node (key);
+            return;
+        }
+
+        index_t curr = m_root, prev = nil;
+        bool key_less {};
+        while ( curr )
+        {
+            auto &curr_links = links (curr);
+            key_less         = compare (key, m_storage.key (curr));
+            if ( !key_less && !compare (m_storage.key (curr), key) )
+            {
+                for ( auto node = prev; node; node = links (node).m_parent )
+                    --links (node).m_size;
+                splay (curr);
+                throw std::out_of_range ("Element already inserted");
+            }
+            ++curr_links.m_size;
+            prev = curr;
+            curr = key_less ? curr_links.m_left : curr_links.m_right;
+        }
+
+        auto to_insert             = create_node (key);
+        links (to_insert).m_parent = prev;
+        if ( key_less )
+        {
+            links (prev).m_left = to_insert;
+            if ( prev == m_leftmost )
+                m_leftmost = to_insert;
+        }
+        else
+        {
+            links (prev).m_right = to_insert;
+            if ( prev == m_rightmost )
+                m_rightmost = to_insert;
+        }
+        splay (to_insert);
+    }
+
+    void erase (const value_type &key)
+    {
+        auto found = find_index (key);
+        if ( !found )
+            throw std::out_of_range ("Element is not presented");
+        erase_index (found);
+    }
+
+    void erase (const_iterator it) { erase_index (it.m_idx); }
+
+    const_iterator find (const value_type &key) const
+    {
+        auto found = find_index (key);
+        return {found, this};
+    }
+
+    bool contains (const value_type &key) const { return find_index (key) != nil; }
+
+    const_iterator lower_bound (const value_type &key) const
+    {
+        return bound ([&] (const T &node_key) { return !compare (node_key, key); });
+    }
+
+    const_iterator upper_bound (const value_type &key) const
+    {
+        return bound ([&] (const T &node_key) { return compare (key, node_key); });
+    }
+
+    const_iterator os_select (size_type p_rank) const
+    {
+        if ( p_rank > size () || !p_rank )
+            return end ();
+
+        auto curr = m_root;
+        while ( true )
+        {
+            size_type rank = links (links (curr).m_left).m_size + 1;
+            if ( rank == p_rank )
+                break;
+            if ( p_rank < rank )
+                curr = links (curr).m_left;
+            else
+            {
+                p_rank -= rank;
+                curr = links (curr).m_right;
+            }
+        }
+        splay (curr);
+        return {curr, this};
+    }
+
+    size_type get_rank_of (const_iterator it) const
+    {
+        auto node      = it.m_idx;
+        size_type rank = links (links (node).m_left).m_size + 1;
+        for ( ; links (node).m_parent; node = links (node).m_parent )
+        {
+            auto parent = links (node).m_parent;
+            if ( links (parent).m_right == node )
+                rank += links (links (parent).m_left).m_size + 1;
+        }
+        return rank;
+    }
+
+    size_type get_number_less_then (const value_type &key) const
+    {
+        auto lb = lower_bound (key);
+        return (lb == end () ? size () : get_rank_of (lb) - 1);
+    }
+
+    size_type count_less (const value_type &key) const
+    {
+        auto lb = lower_bound (key);
+        return (lb == end () ? size () : links (links (m_root).m_left).m_size);
+    }
+
+    size_type count_greater (const value_type &key) const
+    {
+        auto ub = upper_bound (key);
+        return (ub == end () ? 0 : links (links (m_root).m_right).m_size + 1);
+    }
+
+    // number of elements in [lo, hi]: the lower bound of lo is splayed to the root, the rest of
+    // the range is counted in its right subtree with one descent.
+    size_type count_in_range (const value_type &lo, const value_type &hi) const
+    {
+        if ( compare (hi, lo) )
+            return 0;
+        auto lb = lower_bound (lo);
+        if ( lb == end () || compare (hi, *lb) )
+            return 0;
+
+        size_type res = 1;
+        for ( auto curr = links (m_root).m_right; curr; )
+        {
+            if ( compare (hi, m_storage.key (curr)) )
+                curr = links (curr).m_left;
+            else
+            {
+                res += links (links (curr).m_left).m_size + 1;
+                curr = links (curr).m_right;
+            }
+        }
+        return res;
+    }
+
+    bool equal (const self &other) const
+    {
+        return size () == other.size () && std::equal (begin (), end (), other.begin ());
+    }
+
+    void dump (std::ostream &stream) const
+    {
+        assert (stream);
+        stream << "digraph {\nrankdir = TB\n";
+        for ( auto pos = begin (); pos != end (); pos++ )
+        {
+            auto idx = pos.m_idx;
+            stream << "\tnode" << idx << "[label = \"val: " << *pos
+                   << " | size: " << links (idx).m_size
+                   << "\", shape=record, style=filled, fillcolor=palegreen];\n";
+            if ( links (idx).m_left )
+                stream << "\tnode" << idx << " -> node" << links (idx).m_left
+                       << " [color=black, label=\"lchild\"];\n";
+            if ( links (idx).m_right )
+                stream << "\tnode" << idx << " -> node" << links (idx).m_right
+                       << " [color=black, label=\"rchild\"];\n";
+        }
+        stream << "}\n";
+    }
+
+  private:
+    compact_links &links (index_t idx) const { return m_storage.links (idx); }
+
+    bool compare (const value_type &lhs, const value_type &rhs) const
+    {
+        return m_compare (lhs, rhs);
+    }
+
+    index_t create_node (const value_type &key)
+    {
+        index_t res = m_free;
+        if ( res )
+        {
+            m_free              = links (res).m_right;
+            m_storage.key (res) = key;
+        }
+        else
+            res = m_storage.push_back (key);
+        links (res) = {nil, nil, nil, 1};
+        return res;
+    }
+
+    // links the nodes [first, last] into a perfectly balanced subtree and returns its root
+    index_t build_subtree (index_t first, index_t last)
+    {
+        if ( first > last )
+            return nil;
+        auto mid   = first + (last - first) / 2;
+        auto left  = build_subtree (first, mid - 1);
+        auto right = build_subtree (mid + 1, last);
+        links (mid) = {nil, left, right, last - first + 1};
+        if ( left )
+            links (left).m_parent = mid;
+        if ( right )
+            links (right).m_parent = mid;
+        return mid;
+    }
+
+    void free_node (index_t idx)
+    {
+        links (idx) = {nil, nil, m_free, 0};
+        m_free      = idx;
+    }
+
+    index_t minimum (index_t idx) const
+    {
+        while ( links (idx).m_left )
+            idx = links (idx).m_left;
+        return idx;
+    }
+
+    index_t maximum (index_t idx) const
+    {
+        while ( links (idx).m_right )
+            idx = links (idx).m_right;
+        return idx;
+    }
+
+    index_t successor (index_t idx) const
+    {
+        if ( links (idx).m_right )
+            return minimum (links (idx).m_right);
+        auto parent = links (idx).m_parent;
+        while ( parent && links (parent).m_right == idx )
+        {
+            idx    = parent;
+            parent = links (parent).m_parent;
+        }
+        return parent;
+    }
+
+    index_t predecessor (index_t idx) const
+    {
+        if ( links (idx).m_left )
+            return maximum (links (idx).m_left);
+        auto parent = links (idx).m_parent;
+        while ( parent && links (parent).m_left == idx )
+        {
+            idx    = parent;
+            parent = links (parent).m_parent;
+        }
+        return parent;
+    }
+
+    // rotates idx above its parent keeping subtree sizes
+    void rotate_to_parent (index_t idx) const
+    {
+        auto &node_links   = links (idx);
+        auto parent        = node_links.m_parent;
+        auto &parent_links = links (parent);
+        auto grandparent   = parent_links.m_parent;
+
+        if ( parent_links.m_left == idx )
+        {
+            parent_links.m_left = node_links.m_right;
+            if ( node_links.m_right )
+                links (node_links.m_right).m_parent = parent;
+            node_links.m_right = parent;
+        }
+        else
+        {
+            parent_links.m_right = node_links.m_left;
+            if ( node_links.m_left )
+                links (node_links.m_left).m_parent = parent;
+            node_links.m_left = parent;
+        }
+
+        node_links.m_parent   = grandparent;
+        parent_links.m_parent = idx;
+        if ( !grandparent )
+            m_root = idx;
+        else if ( links (grandparent).m_left == parent )
+            links (grandparent).m_left = idx;
+        else
+            links (grandparent).m_right = idx;
+
+        node_links.m_size   = parent_links.m_size;
+        parent_links.m_size = links (parent_links.m_left).m_size +
+                              links (parent_links.m_right).m_size + 1;
+    }
+
+    void splay (index_t idx) const
+    {
+        assert (idx);
+        while ( auto parent = links (idx).m_parent )
+        {
+            if ( auto grandparent = links (parent).m_parent )
+            {
+                bool linear =
+                    (links (parent).m_left == idx) == (links (grandparent).m_left == parent);
+                rotate_to_parent (linear ? parent : idx);
+            }
+            rotate_to_parent (idx);
+        }
+    }
+
+    index_t find_index (const value_type &key) const
+    {
+        index_t curr = m_root, last = nil;
+        while ( curr )
+        {
+            last = curr;
+            if ( compare (key, m_storage.key (curr)) )
+                curr = links (curr).m_left;
+            else if ( compare (m_storage.key (curr), key) )
+                curr = links (curr).m_right;
+            else
+                break;
+        }
+        if ( last )
+            splay (curr ? curr : last);
+        return curr;
+    }
+
+    // returns the first node satisfying the predicate, which must partition the keys.
+    template <typename F> const_iterator bound (F pred) const
+    {
+        index_t curr = m_root, last = nil, res = nil;
+        while ( curr )
+        {
+            last = curr;
+            if ( pred (m_storage.key (curr)) )
+            {
+                res  = curr;
+                curr = links (curr).m_left;
+            }
+            else
+                curr = links (curr).m_right;
+        }
+        if ( last )
+            splay (res ? res : last);
+        return {res, this};
+    }
+
+    void erase_index (index_t idx)
+    {
+        assert (idx);
+        if ( idx == m_leftmost )
+            m_leftmost = successor (idx);
+        if ( idx == m_rightmost )
+            m_rightmost = predecessor (idx);
+
+        splay (idx);
+        auto left  = links (idx).m_left;
+        auto right = links (idx).m_right;
+        if ( !left )
+            m_root = right;
+        else
+        {
+            // make the left subtree a tree of its own and bring its maximum to the top
+            links (left).m_parent = nil;
+            m_root                = left;
+            auto left_max         = maximum (left);
+            splay (left_max);
+            links (left_max).m_right = right;
+            links (left_max).m_size += links (right).m_size;
+        }
+        if ( right && m_root == right )
+            links (right).m_parent = nil;
+        else if ( right )
+            links (right).m_parent = m_root;
+        free_node (idx);
+    }
+};
+
+template <typename T, typename Compare_t, bool Split_keys>
+bool operator== (const compact_splay_order_set<T, Compare_t, Split_keys> &lhs,
+                 const compact_splay_order_set<T, Compare_t, Split_keys> &rhs)
+{
+    return lhs.equal (rhs);
+}
+
+template <typename T, typename Compare_t, bool Split_keys>
+bool operator!= (const compact_splay_order_set<T, Compare_t, Split_keys> &lhs,
+                 const compact_splay_order_set<T, Compare_t, Split_keys> &rhs)
+{
+    return !(lhs == rhs);
+}
+
+}   // namespace containers
+}   // namespace red
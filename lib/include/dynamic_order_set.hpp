@@ -18,54 +18,77 @@
 #include <cassert>
 #include <cstddef>
 #include <fstream>
+#include <future>
 #include <iterator>
 #include <memory>
+#include <ranges>
+#include <span>
+#include <thread>
 #include <tuple>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace red
 {
 namespace containers
 {
-template <typename T, class Compare_t = std::less<T>>
-struct dynamic_order_set : public base_set<T, Compare_t>
+// Node_t is dynamic_order_set_node or a node derived from it that carries balancing data, see
+// balanced_order_set.hpp, or a monoid aggregate, see augmentation.hpp
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>,
+          class Node_t = dynamic_order_set_node<T>>
+struct dynamic_order_set : public base_set<T, Compare_t, Alloc_t, Node_t>
 {
   protected:
-    using base          = base_set<T, Compare_t>;
-    using node          = dynamic_order_set_node<T>;
+    using base          = base_set<T, Compare_t, Alloc_t, Node_t>;
+    using node          = Node_t;
     using node_ptr      = node *;
     using const_node_ptr = const node *;
     using base_node     = typename base::base_node;
     using base_node_ptr = typename base::base_node_ptr;
 
+    // the node keeps a monoid aggregate of its subtree, see augmentation.hpp
+    static constexpr bool augmented = requires (base_node_ptr ptr) { node::aggregate (ptr); };
+
+    // the node counts copies of its value, see splay_order_multiset.hpp
+    static constexpr bool counted = requires (base_node_ptr ptr) { node::multiplicity_ref (ptr); };
+
   public:
     using value_type = T;
     using size_type  = typename node::size_type;
 
+    template <typename K> using key_arg = typename base::template key_arg<K>;
+
+    using base::base;
+
     using typename base::const_iterator;
     using typename base::const_reverse_iterator;
     using typename base::iterator;
     using typename base::reverse_iterator;
 
-    void insert (const value_type &key) override
+    void insert (const value_type &key) { emplace (key); }
+
+    void insert (value_type &&key) { emplace (std::move (key)); }
+
+    template <typename... Args> void emplace (Args &&...args)
     {
-        auto to_insert_uptr = std::make_unique<node> (key);
-        auto to_insert      = to_insert_uptr.get ();
-        base::insert_node_to_nodes (std::move (to_insert_uptr));
-        base::insert_base (
-            to_insert, [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size++; },
-            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; });
+        auto inserted = base::emplace_value (
+            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size++; },
+            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; },
+            std::forward<Args> (args)...);
+        if constexpr ( augmented )
+            update_up (inserted);
     }
 
-    void erase (const value_type &key) override
+    template <typename K = value_type> void erase (const key_arg<K> &key)
     {
         auto to_erase = base::find_for_erase (
-            key, [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; },
-            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size++; });
-        base::erase_base (to_erase);
+            key, [] (base_node_ptr) {}, [] (base_node_ptr) {});
+        erase_node (to_erase);
     }
 
-    void dump (std::ostream &stream) const override
+    void erase (iterator it) { erase_node (it.m_node); }
+
+    void dump (std::ostream &stream) const
     {
         assert (stream);
         stream << "digraph {\nrankdir = TB\n";
@@ -107,50 +130,311 @@ struct dynamic_order_set : public base_set<T, Compare_t>
         if ( p_rank > base::size () || !p_rank )
             return iterator {nullptr, this};
 
+        // the copies of curr take the ranks from rank to rank + multiplicity - 1
         auto curr      = base::root ();
-        size_type rank = (curr->m_left ? node::size (curr->m_left) : 0) + 1;
-        while ( rank != p_rank )
+        size_type rank = node::size (curr->m_left) + 1;
+        while ( p_rank < rank || p_rank >= rank + node::multiplicity (curr) )
         {
             if ( p_rank < rank )
                 curr = curr->m_left;
             else
             {
+                p_rank -= rank - 1 + node::multiplicity (curr);
                 curr = curr->m_right;
-                p_rank -= rank;
             }
-            rank = (curr->m_left ? node::size (curr->m_left) : 0) + 1;
+            rank = node::size (curr->m_left) + 1;
         }
         return iterator {static_cast<node_ptr> (curr), this};
     }
 
-    size_type get_number_less_then (value_type val) const
+    template <typename K = value_type> size_type get_number_less_then (const key_arg<K> &val) const
     {
         if ( base::empty () )
             return 0;
         const auto &min_val = static_cast<node_ptr> (base::leftmost ())->m_value;
-        if ( base::compare (val, min_val) || val == min_val )
+        if ( !base::compare (min_val, val) )
             return 0;
         auto closest_left = --base::upper_bound (val);
         auto rank         = get_rank_of (closest_left.m_node);
-        return (*closest_left == val ? rank - 1 : rank);
+        return rank - 1 +
+               (base::compare (*closest_left, val) ? node::multiplicity (closest_left.m_node) : 0);
     }
 
     size_type get_rank_of (const iterator it) const { return get_rank_of (it.m_node); }
 
+    // number of elements less than key
+    template <typename K = value_type> size_type count_less (const key_arg<K> &key) const
+    {
+        return count_prefix (base::root (), [this, &key] (const value_type &value) {
+            return base::compare (value, key);
+        });
+    }
+
+    // number of elements greater than key
+    template <typename K = value_type> size_type count_greater (const key_arg<K> &key) const
+    {
+        return base::size () - count_not_greater (base::root (), key);
+    }
+
+    // number of elements in [lo, hi], 0 if hi < lo
+    template <typename K1 = value_type, typename K2 = K1>
+    size_type count_in_range (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+    {
+        return count_in_range_base (lo, hi);
+    }
+
+    // aggregate of all the elements, requires an augmented node
+    auto aggregate () const
+        requires augmented
+    {
+        return node::aggregate (base::root ());
+    }
+
+    // aggregate of the elements in [lo, hi], identity if hi < lo. Two descents from the node
+    // where the paths to lo and hi part, no restructuring.
+    template <typename K1 = value_type, typename K2 = K1>
+    auto aggregate (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+        requires augmented
+    {
+        using augment = typename node::augment_type;
+        auto curr     = base::root ();
+        while ( curr && !base::compare (hi, lo) )
+        {
+            const auto &value = static_cast<node_ptr> (curr)->m_value;
+            if ( base::compare (value, lo) )
+                curr = curr->m_right;
+            else if ( base::compare (hi, value) )
+                curr = curr->m_left;
+            else
+                return augment::combine (
+                    augment::combine (fold_suffix (curr->m_left, not_less (lo)), node::of (curr)),
+                    fold_prefix (curr->m_right, not_greater (hi)));
+        }
+        return augment::identity ();
+    }
+
+    // The first element whose prefix aggregate, the element included, satisfies pred, end () if
+    // there is none. pred must be monotone along the prefixes, false on the shorter ones and true
+    // on the longer ones, e.g. "the prefix sum exceeds x" for non-negative elements.
+    template <typename F>
+    iterator find_by_prefix (F pred) const
+        requires augmented
+    {
+        return iterator {static_cast<node_ptr> (search_prefix (pred)), this};
+    }
+
+    // Answers count_in_range for every (lo, hi) pair of the range, any pair-like type that
+    // supports structured bindings will do. The tree is never restructured, so the queries are
+    // split in chunks between up to n_threads threads, the calling one included. Every thread
+    // gets at least min_batch_chunk (16384) queries, so batches of fewer than 32768 queries are
+    // answered on the calling thread without starting any. The set must not be modified until
+    // the call returns.
+    template <std::ranges::random_access_range Range =
+                  std::span<const std::pair<value_type, value_type>>>
+    std::vector<size_type>
+    count_in_ranges (const Range &queries,
+                     unsigned n_threads = std::thread::hardware_concurrency ()) const
+    {
+        std::vector<size_type> res (std::ranges::distance (queries));
+        auto count_chunk = [this, &queries, &res] (std::size_t first, std::size_t last) {
+            for ( ; first != last; ++first )
+            {
+                const auto &[lo, hi] = queries[first];
+                res[first]           = count_in_range_base (lo, hi);
+            }
+        };
+
+        std::size_t n_chunks = std::clamp<std::size_t> (res.size () / min_batch_chunk, 1,
+                                                        std::max (n_threads, 1u));
+        if ( n_chunks == 1 )
+        {
+            count_chunk (0, res.size ());
+            return res;
+        }
+
+        std::size_t chunk = res.size () / n_chunks;
+        std::vector<std::future<void>> workers;
+        workers.reserve (n_chunks - 1);
+        for ( std::size_t i = 1; i < n_chunks; ++i )
+        {
+            auto last = (i + 1 == n_chunks ? res.size () : (i + 1) * chunk);
+            workers.push_back (std::async (std::launch::async, count_chunk, i * chunk, last));
+        }
+        count_chunk (0, chunk);
+        for ( auto &worker : workers )
+            worker.get ();
+        return res;
+    }
+
   protected:
-    virtual size_type get_rank_of (base_node_ptr node) const
+    // Smallest number of queries worth a separate thread in count_in_ranges. Starting a thread
+    // costs tens of microseconds, a chunk this large takes about a millisecond.
+    static constexpr std::size_t min_batch_chunk = 16384;
+
+    template <typename K1, typename K2>
+    size_type count_in_range_base (const K1 &lo, const K2 &hi) const
+    {
+        if ( base::compare (hi, lo) )
+            return 0;
+        return count_not_greater (base::root (), hi) - count_less (lo);
+    }
+
+    // Counts the nodes of the subtree for which pred holds, pred must hold on a prefix of the
+    // in-order sequence. One descent, no restructuring.
+    template <typename F> size_type count_prefix (base_node_ptr curr, F pred) const
+    {
+        size_type res = 0;
+        while ( curr )
+        {
+            if ( pred (static_cast<node_ptr> (curr)->m_value) )
+            {
+                res += node::size (curr->m_left) + node::multiplicity (curr);
+                curr = curr->m_right;
+            }
+            else
+                curr = curr->m_left;
+        }
+        return res;
+    }
+
+    template <typename K> size_type count_not_greater (base_node_ptr curr, const K &key) const
+    {
+        return count_prefix (curr, not_greater (key));
+    }
+
+    template <typename K> auto not_greater (const K &key) const
+    {
+        return [this, &key] (const value_type &value) { return !base::compare (key, value); };
+    }
+
+    template <typename K> auto not_less (const K &key) const
+    {
+        return [this, &key] (const value_type &value) { return !base::compare (value, key); };
+    }
+
+    // Recomputes the data of node and of its ancestors after the subtree of node has changed.
+    static void update_up (base_node_ptr node)
+    {
+        for ( ; node->m_parent; node = node->m_parent )
+            node::update (node);
+    }
+
+    // Aggregate of the nodes of the subtree for which pred holds, pred must hold on a prefix of
+    // the in-order sequence.
+    template <typename F> auto fold_prefix (base_node_ptr curr, F pred) const
+    {
+        using augment = typename node::augment_type;
+        auto res      = augment::identity ();
+        while ( curr )
+        {
+            if ( pred (static_cast<node_ptr> (curr)->m_value) )
+            {
+                res  = augment::combine (res, augment::combine (node::aggregate (curr->m_left),
+                                                                node::of (curr)));
+                curr = curr->m_right;
+            }
+            else
+                curr = curr->m_left;
+        }
+        return res;
+    }
+
+    // the same for pred holding on a suffix
+    template <typename F> auto fold_suffix (base_node_ptr curr, F pred) const
+    {
+        using augment = typename node::augment_type;
+        auto res      = augment::identity ();
+        while ( curr )
+        {
+            if ( pred (static_cast<node_ptr> (curr)->m_value) )
+            {
+                res  = augment::combine (augment::combine (node::of (curr),
+                                                           node::aggregate (curr->m_right)),
+                                         res);
+                curr = curr->m_left;
+            }
+            else
+                curr = curr->m_right;
+        }
+        return res;
+    }
+
+    // finds the node for find_by_prefix, nullptr if there is none
+    template <typename F> base_node_ptr search_prefix (F pred) const
+    {
+        return search_prefix (pred, [] (base_node_ptr) {});
+    }
+
+    // "step" applies to every node on the path
+    template <typename F, typename S> base_node_ptr search_prefix (F pred, S step) const
+    {
+        using augment = typename node::augment_type;
+        auto prefix   = augment::identity ();
+        auto curr     = base::root ();
+        base_node_ptr res {};
+        while ( curr )
+        {
+            step (curr);
+            // if pred already holds before curr, curr is the answer unless its left subtree has one
+            auto left = augment::combine (prefix, node::aggregate (curr->m_left));
+            if ( pred (std::as_const (left)) )
+            {
+                res  = curr;
+                curr = curr->m_left;
+                continue;
+            }
+            prefix = augment::combine (left, node::of (curr));
+            if ( pred (std::as_const (prefix)) )
+                return curr;
+            curr = curr->m_right;
+        }
+        return res;
+    }
+
+    // Unlinks the node from the tree, fixing the subtree sizes on the way up, and returns the
+    // parent it hung on at last and the child that took its place or nullptr. Freeing the node
+    // is left to the caller. With counted nodes the nodes between the places swapped by
+    // update_bounds_for_erase lose the successor's copies rather than the erased ones, so the
+    // sizes are recomputed instead of decremented.
+    std::pair<base_node_ptr, base_node_ptr> unlink_node (base_node_ptr to_erase)
+    {
+        base::update_bounds_for_erase (to_erase, [] (base_node_ptr) {});
+        if constexpr ( !counted )
+            for ( auto curr = to_erase; curr != base::root (); )
+            {
+                curr = curr->m_parent;
+                --node::size_ref (curr);
+            }
+        auto parent = to_erase->m_parent;
+        auto child  = (to_erase->m_left ? to_erase->m_left : to_erase->m_right);
+        base::evict_node_for_erase (to_erase);
+        if constexpr ( augmented || counted )
+            update_up (parent);
+        return {parent, child};
+    }
+
+    void erase_node (base_node_ptr to_erase)
+    {
+        unlink_node (to_erase);
+        base::destroy_node (to_erase);
+        base::decr_size ();
+    }
+
+    size_type get_rank_of (base_node_ptr node) const
     {
         auto [node_dummy, rank] = get_rank_of_base (node);
         return rank;
     }
 
+    // rank of the first copy of the value of node
     std::pair<base_node_ptr, size_type> get_rank_of_base (base_node_ptr node) const
     {
         size_type rank = (node->m_left ? node::size (node->m_left) + 1 : 1);
         while ( node != base::root () )
         {
+            base::count (stat::rank_steps);
             if ( !node->is_left_child () )
-                rank += (node->m_parent->m_left ? node::size (node->m_parent->m_left) + 1 : 1);
+                rank += node::size (node->m_parent->m_left) + node::multiplicity (node->m_parent);
             node = node->m_parent;
         }
         return {node, rank};
@@ -0,0 +1,270 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// slab allocator for tree nodes
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace red
+{
+namespace containers
+{
+
+// fixed-size slot storage: slots are carved out of large slabs and recycled through an intrusive
+// free list, so allocating and freeing a node never reaches the system allocator after warm-up.
+class slab_resource
+{
+    struct free_slot
+    {
+        free_slot *m_next;
+    };
+
+    struct slab_deleter
+    {
+        std::align_val_t m_align;
+
+        void operator() (std::byte *slab) const { ::operator delete (slab, m_align); }
+    };
+
+    using slab_ptr = std::unique_ptr<std::byte[], slab_deleter>;
+
+    static constexpr std::size_t min_slab_size = 64;
+    static constexpr std::size_t max_slab_size = std::size_t {1} << 16;
+
+    std::size_t m_object_size;
+    std::size_t m_object_align;
+    std::size_t m_slot_align;
+    std::size_t m_slot_size;
+    std::vector<slab_ptr> m_slabs;
+    free_slot *m_free   = nullptr;
+    std::byte *m_cursor = nullptr;
+    std::byte *m_end    = nullptr;
+    std::size_t m_free_count     = 0;
+    std::size_t m_next_slab_size = min_slab_size;
+
+    // Starts a new slab of n slots. The unused tail of the current slab goes to the free list.
+    void grow (std::size_t n)
+    {
+        for ( ; m_cursor != m_end; m_cursor += m_slot_size )
+            push_free (m_cursor);
+        auto align = std::align_val_t {m_slot_align};
+        m_slabs.push_back (
+            slab_ptr {static_cast<std::byte *> (::operator new (n * m_slot_size, align)), {align}});
+        m_cursor         = m_slabs.back ().get ();
+        m_end            = m_cursor + n * m_slot_size;
+        m_next_slab_size = std::min (2 * m_next_slab_size, max_slab_size);
+    }
+
+    void push_free (void *to_free)
+    {
+        m_free = ::new (to_free) free_slot {m_free};
+        ++m_free_count;
+    }
+
+  public:
+    // slots for objects of the given size and alignment
+    slab_resource (std::size_t size, std::size_t align)
+        : m_object_size {size}, m_object_align {align},
+          m_slot_align {std::max (align, alignof (free_slot))},
+          m_slot_size {(std::max (size, sizeof (free_slot)) + m_slot_align - 1) / m_slot_align *
+                       m_slot_align}
+    {
+    }
+
+    std::size_t object_size () const { return m_object_size; }
+
+    std::size_t object_align () const { return m_object_align; }
+
+    void *allocate ()
+    {
+        if ( m_free )
+        {
+            auto res = m_free;
+            m_free   = m_free->m_next;
+            --m_free_count;
+            return res;
+        }
+        if ( m_cursor == m_end )
+            grow (m_next_slab_size);
+        return std::exchange (m_cursor, m_cursor + m_slot_size);
+    }
+
+    void deallocate (void *ptr) { push_free (ptr); }
+
+    // Makes sure that next n allocations are served without growing.
+    void reserve (std::size_t n)
+    {
+        auto available =
+            m_free_count + static_cast<std::size_t> (m_end - m_cursor) / m_slot_size;
+        if ( available < n )
+            grow (n - available);
+    }
+
+    // Takes over the slabs of other together with its free slots, other is left empty. Both must
+    // serve the same objects. Runs in time linear in the number of slabs and in the shorter of the
+    // two free lists.
+    void adopt (slab_resource &other)
+    {
+        for ( auto &slab : other.m_slabs )
+            m_slabs.push_back (std::move (slab));
+
+        // only one unused slab tail can be carved from, the shorter one goes to the free list
+        if ( other.m_end - other.m_cursor > m_end - m_cursor )
+        {
+            std::swap (m_cursor, other.m_cursor);
+            std::swap (m_end, other.m_end);
+        }
+        for ( ; other.m_cursor != other.m_end; other.m_cursor += m_slot_size )
+            push_free (other.m_cursor);
+
+        if ( other.m_free )
+        {
+            auto shorter = (other.m_free_count < m_free_count ? other.m_free : m_free);
+            auto longer  = (shorter == m_free ? other.m_free : m_free);
+            auto tail    = shorter;
+            while ( tail && tail->m_next )
+                tail = tail->m_next;
+            if ( tail )
+                tail->m_next = longer;
+            m_free = (tail ? shorter : longer);
+            m_free_count += other.m_free_count;
+        }
+        m_next_slab_size = std::max (m_next_slab_size, other.m_next_slab_size);
+        other.release ();
+    }
+
+    // Returns all the slabs at once. Objects still living in them are not destroyed.
+    void release ()
+    {
+        m_slabs.clear ();
+        m_free           = nullptr;
+        m_cursor         = nullptr;
+        m_end            = nullptr;
+        m_free_count     = 0;
+        m_next_slab_size = min_slab_size;
+    }
+};
+
+// The slab resources of one arena, one per object size. An allocator and all the allocators
+// rebound from it share the pool, so memory allocated through one of them can be freed through
+// any other.
+class arena_pool
+{
+    std::vector<std::unique_ptr<slab_resource>> m_resources;
+
+  public:
+    slab_resource &resource (std::size_t size, std::size_t align)
+    {
+        for ( auto &res : m_resources )
+            if ( res->object_size () == size && res->object_align () == align )
+                return *res;
+        return *m_resources.emplace_back (std::make_unique<slab_resource> (size, align));
+    }
+
+    // takes over the slabs of every resource of other
+    void adopt (arena_pool &other)
+    {
+        for ( auto &res : other.m_resources )
+            resource (res->object_size (), res->object_align ()).adopt (*res);
+    }
+
+    void release ()
+    {
+        for ( auto &res : m_resources )
+            res->release ();
+    }
+};
+
+// Allocator over an arena_pool. Copies and rebound copies share the pool (and compare equal),
+// copying a container starts a fresh one. Moving an allocator copies it, so the source stays
+// usable and equal to the result. Only single-object allocations go through the slabs, arrays
+// fall back to std::allocator.
+template <typename T> class node_arena
+{
+    template <typename U> friend class node_arena;
+
+    std::shared_ptr<arena_pool> m_pool;
+    // the resource of the pool serving T, looked up on first use
+    slab_resource *m_resource = nullptr;
+
+    slab_resource &resource ()
+    {
+        if ( !m_resource )
+            m_resource = &m_pool->resource (sizeof (T), alignof (T));
+        return *m_resource;
+    }
+
+  public:
+    using value_type                             = T;
+    using size_type                              = std::size_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::false_type;
+
+    node_arena () : m_pool {std::make_shared<arena_pool> ()} {}
+
+    node_arena (const node_arena &) noexcept = default;
+    node_arena &operator= (const node_arena &) noexcept = default;
+
+    template <typename U> node_arena (const node_arena<U> &other) noexcept : m_pool {other.m_pool}
+    {
+    }
+
+    T *allocate (size_type n)
+    {
+        if ( n == 1 )
+            return static_cast<T *> (resource ().allocate ());
+        return std::allocator<T> {}.allocate (n);
+    }
+
+    void deallocate (T *ptr, size_type n)
+    {
+        if ( n == 1 )
+            resource ().deallocate (ptr);
+        else
+            std::allocator<T> {}.deallocate (ptr, n);
+    }
+
+    void reserve (size_type n) { resource ().reserve (n); }
+
+    // Drops every slab of the shared pool. Callers must make sure that no copy of this
+    // allocator still owns live objects.
+    void release () { m_pool->release (); }
+
+    // Takes over the memory of other if no other allocator shares its pool. From then on
+    // the objects allocated by other are freed through this allocator.
+    bool adopt (node_arena &other)
+    {
+        if ( !other.exclusive () )
+            return false;
+        m_pool->adopt (*other.m_pool);
+        return true;
+    }
+
+    // true if no other allocator shares the pool.
+    bool exclusive () const { return m_pool.use_count () == 1; }
+
+    node_arena select_on_container_copy_construction () const { return node_arena {}; }
+
+    friend bool operator== (const node_arena &lhs, const node_arena &rhs)
+    {
+        return lhs.m_pool == rhs.m_pool;
+    }
+};
+
+}   // namespace containers
+}   // namespace red
@@ -0,0 +1,293 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// order statistic set partitioned by key range between independently locked shards
+
+#pragma once
+
+#include "splay_dynamic_order_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+namespace red
+{
+namespace containers
+{
+
+// Shard i holds the keys k with m_bounds[i - 1] <= k < m_bounds[i]. Updates lock only the shard
+// they go to, global queries lock the shards they need in index order and combine the answers
+// through prefix sums of shard sizes. Boundaries are moved only by rebalance () under an
+// exclusive lock, which it takes by itself when a shard grows much larger than the average.
+// Until the first rebalance all keys go to the first shard.
+//
+// The lock over the boundaries is striped: every thread takes a shared lock on one of
+// n_bounds_slots mutexes and rebalance () locks all of them, so threads updating different shards
+// write no common cache line. The number of keys is kept per shard for the same reason.
+template <typename T, class Compare_t = std::less<T>,
+          class Set_t = splay_dynamic_order_set<T, Compare_t>>
+class sharded_order_set
+{
+  public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    // A shard is rebalanced when it holds more than skew_percent percent of the average number of
+    // keys plus min_rebalance_size. The factor has to stay below the number of shards, otherwise
+    // even a shard holding every key would not count as skewed.
+    static constexpr size_type skew_percent       = 150;
+    static constexpr size_type min_rebalance_size = 4096;
+
+    // an update checks the shards for skew once per this many keys inserted into its shard
+    static constexpr size_type skew_check_period = 64;
+
+    static constexpr size_type n_bounds_slots = 64;
+
+  private:
+    static constexpr std::size_t cache_line = 64;
+
+    struct alignas (cache_line) shard
+    {
+        mutable std::mutex m_mutex;
+        Set_t m_set;
+        // written under m_mutex, read without it by size ()
+        std::atomic<size_type> m_count {0};
+    };
+
+    struct alignas (cache_line) bounds_slot
+    {
+        mutable std::shared_mutex m_mutex;
+    };
+
+    Compare_t m_compare;
+    std::vector<shard> m_shards;
+    std::vector<value_type> m_bounds;
+    std::array<bounds_slot, n_bounds_slots> m_bounds_slots;
+
+    using shard_lock  = std::unique_lock<std::mutex>;
+    using bounds_lock = std::unique_lock<std::shared_mutex>;
+
+  public:
+    explicit sharded_order_set (size_type n_shards, const Compare_t &comp = Compare_t {})
+        : m_compare {comp}, m_shards (std::max<size_type> (n_shards, 1))
+    {
+    }
+
+    sharded_order_set (const sharded_order_set &)            = delete;
+    sharded_order_set &operator= (const sharded_order_set &) = delete;
+
+    size_type n_shards () const { return m_shards.size (); }
+
+    // exact when no update runs concurrently
+    size_type size () const
+    {
+        size_type res = 0;
+        for ( const auto &sh : m_shards )
+            res += sh.m_count.load (std::memory_order_relaxed);
+        return res;
+    }
+
+    bool empty () const { return !size (); }
+
+    size_type shard_size (size_type idx) const
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        std::lock_guard lock {m_shards[idx].m_mutex};
+        return m_shards[idx].m_set.size ();
+    }
+
+    void insert (const value_type &key)
+    {
+        bool skewed = false;
+        {
+            std::shared_lock bounds_lock {bounds_mutex ()};
+            auto &dest = m_shards[shard_of (key)];
+            std::lock_guard lock {dest.m_mutex};
+            dest.m_set.insert (key);
+            auto count = dest.m_set.size ();
+            dest.m_count.store (count, std::memory_order_relaxed);
+            skewed = count % skew_check_period == 0 && is_skewed (count);
+        }
+        if ( skewed )
+            rebalance_if_skewed ();
+    }
+
+    void erase (const value_type &key)
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        auto &dest = m_shards[shard_of (key)];
+        std::lock_guard lock {dest.m_mutex};
+        dest.m_set.erase (key);
+        dest.m_count.store (dest.m_set.size (), std::memory_order_relaxed);
+    }
+
+    bool contains (const value_type &key) const
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        const auto &dest = m_shards[shard_of (key)];
+        std::lock_guard lock {dest.m_mutex};
+        return dest.m_set.find (key) != dest.m_set.end ();
+    }
+
+    size_type count_less (const value_type &key) const
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        auto idx   = shard_of (key);
+        auto locks = lock_shards (0, idx + 1);
+        return count_less_locked (key, idx);
+    }
+
+    // number of elements in [lo, hi], 0 if hi < lo
+    size_type count_in_range (const value_type &lo, const value_type &hi) const
+    {
+        if ( m_compare (hi, lo) )
+            return 0;
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        auto first = shard_of (lo), last = shard_of (hi);
+        auto locks = lock_shards (first, last + 1);
+        if ( first == last )
+            return m_shards[first].m_set.count_in_range (lo, hi);
+
+        const auto &first_set = m_shards[first].m_set, &last_set = m_shards[last].m_set;
+        size_type res = first_set.size () - first_set.count_less (lo) + last_set.size () -
+                        last_set.count_greater (hi);
+        for ( auto i = first + 1; i < last; ++i )
+            res += m_shards[i].m_set.size ();
+        return res;
+    }
+
+    // element of the given rank (starting with 1), std::nullopt if there is no such rank
+    std::optional<value_type> os_select (size_type rank) const
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        auto locks = lock_shards (0, n_shards ());
+        std::vector<size_type> prefix (n_shards () + 1);
+        for ( size_type i = 0; i < n_shards (); ++i )
+            prefix[i + 1] = prefix[i] + m_shards[i].m_set.size ();
+        if ( !rank || rank > prefix.back () )
+            return std::nullopt;
+
+        auto idx = std::lower_bound (prefix.begin (), prefix.end (), rank) - prefix.begin () - 1;
+        return *m_shards[idx].m_set.os_select (rank - prefix[idx]);
+    }
+
+    // rank of the key (starting with 1), std::nullopt if it is not in the set
+    std::optional<size_type> get_rank_of (const value_type &key) const
+    {
+        std::shared_lock bounds_lock {bounds_mutex ()};
+        auto idx   = shard_of (key);
+        auto locks = lock_shards (0, idx + 1);
+        const auto &dest = m_shards[idx].m_set;
+        if ( dest.find (key) == dest.end () )
+            return std::nullopt;
+        return count_less_locked (key, idx) + 1;
+    }
+
+    // Moves the boundaries so that every shard gets the same number of keys. Shards are rebuilt
+    // from their sorted contents in O(n).
+    void rebalance ()
+    {
+        auto locks = lock_bounds ();
+        rebalance_locked ();
+    }
+
+  private:
+    // the slot of the calling thread, threads are spread over the slots in order of first use
+    std::shared_mutex &bounds_mutex () const
+    {
+        static std::atomic<size_type> next_slot {0};
+        thread_local const size_type slot =
+            next_slot.fetch_add (1, std::memory_order_relaxed) % n_bounds_slots;
+        return m_bounds_slots[slot].m_mutex;
+    }
+
+    // exclusive lock over the boundaries, slots are locked in index order
+    std::vector<bounds_lock> lock_bounds ()
+    {
+        std::vector<bounds_lock> locks;
+        locks.reserve (n_bounds_slots);
+        for ( auto &slot : m_bounds_slots )
+            locks.emplace_back (slot.m_mutex);
+        return locks;
+    }
+
+    size_type shard_of (const value_type &key) const
+    {
+        return std::upper_bound (m_bounds.begin (), m_bounds.end (), key, m_compare) -
+               m_bounds.begin ();
+    }
+
+    // shards are always locked in index order, so global queries never deadlock each other
+    std::vector<shard_lock> lock_shards (size_type first, size_type last) const
+    {
+        std::vector<shard_lock> locks;
+        locks.reserve (last - first);
+        for ( ; first != last; ++first )
+            locks.emplace_back (m_shards[first].m_mutex);
+        return locks;
+    }
+
+    // expects the shards up to idx to be locked
+    size_type count_less_locked (const value_type &key, size_type idx) const
+    {
+        size_type res = 0;
+        for ( size_type i = 0; i < idx; ++i )
+            res += m_shards[i].m_set.size ();
+        return res + m_shards[idx].m_set.count_less (key);
+    }
+
+    bool is_skewed (size_type shard_size) const
+    {
+        return n_shards () > 1 &&
+               shard_size > skew_percent * size () / (100 * n_shards ()) + min_rebalance_size;
+    }
+
+    void rebalance_if_skewed ()
+    {
+        auto locks = lock_bounds ();
+        // another thread may have rebalanced while we were waiting for the lock
+        if ( std::any_of (m_shards.begin (), m_shards.end (),
+                          [this] (const shard &sh) { return is_skewed (sh.m_count); }) )
+            rebalance_locked ();
+    }
+
+    void rebalance_locked ()
+    {
+        if ( size () < n_shards () )
+            return;
+
+        std::vector<value_type> keys;
+        keys.reserve (size ());
+        for ( auto &sh : m_shards )
+            keys.insert (keys.end (), sh.m_set.begin (), sh.m_set.end ());
+
+        std::vector<value_type> bounds;
+        bounds.reserve (n_shards () - 1);
+        for ( size_type i = 0; i < n_shards (); ++i )
+        {
+            auto first = keys.begin () + i * keys.size () / n_shards ();
+            auto last  = keys.begin () + (i + 1) * keys.size () / n_shards ();
+            if ( i )
+                bounds.push_back (*first);
+            m_shards[i].m_set = Set_t (first, last, m_compare);
+            m_shards[i].m_count.store (m_shards[i].m_set.size (), std::memory_order_relaxed);
+        }
+        m_bounds = std::move (bounds);
+    }
+};
+
+}   // namespace containers
+}   // namespace red
@@ -11,19 +11,30 @@
 
 #pragma once
 
+#include "augmentation.hpp"
 #include "dynamic_order_set.hpp"
+#include "splay_policy.hpp"
+
+#include <tuple>
+#include <utility>
 
 namespace red
 {
 namespace containers
 {
 
-template <typename T, class Compare_t = std::less<T>>
-struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
+// Splay_t selects the splaying engine, see splay_policy.hpp. Node_t may add a monoid
+// aggregate to the subtree sizes, see augmented_splay_set below.
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>,
+          class Splay_t = bottom_up_splay, class Node_t = dynamic_order_set_node<T>>
+struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t, Alloc_t, Node_t>
 {
-  private:
-    using base_set    = base_set<T, Compare_t>;
-    using base_do_set = dynamic_order_set<T, Compare_t>;
+    static_assert (!Splay_t::is_top_down || (!Splay_t::is_semi && !Splay_t::is_conditional),
+                   "the top-down engine always splays fully");
+
+  protected:
+    using base_do_set = dynamic_order_set<T, Compare_t, Alloc_t, Node_t>;
+    using base_set    = typename base_do_set::base;
     using typename base_do_set::base_node;
     using typename base_do_set::base_node_ptr;
     using typename base_do_set::const_node_ptr;
@@ -34,6 +45,8 @@ struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
     using typename base_do_set::size_type;
     using typename base_do_set::value_type;
 
+    template <typename K> using key_arg = typename base_do_set::template key_arg<K>;
+
     using typename base_do_set::const_iterator;
     using typename base_do_set::const_reverse_iterator;
     using typename base_do_set::iterator;
@@ -41,19 +54,475 @@ struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
 
     using base_set::dump;
 
+    using base_do_set::aggregate;
+
+    using base_do_set::base_do_set;
+
   private:
-    void splay (base_node_ptr node) const
+    // lookups leave the found node at the root, which the count_* queries rely on
+    static constexpr bool brings_to_root = !Splay_t::is_semi && !Splay_t::is_conditional;
+
+    [[no_unique_address]] mutable Splay_t m_policy {};
+
+  public:
+    // the parameters of the policy, e.g. the probability of randomized_splay
+    Splay_t &splay_policy () { return m_policy; }
+
+    const Splay_t &splay_policy () const { return m_policy; }
+
+    // Read-only access to the set that never splays: every lookup is a plain descent, so any
+    // number of threads may share views of one set without locking. Neither the set itself nor
+    // its splaying lookups may be used while views are being read; writers simply go back to
+    // the set, which keeps adapting to the access pattern from then on.
+    class read_only_view
+    {
+        const splay_dynamic_order_set *m_set;
+
+      public:
+        explicit read_only_view (const splay_dynamic_order_set &set) : m_set {&set} {}
+
+        size_type size () const { return m_set->size (); }
+        bool empty () const { return m_set->empty (); }
+
+        iterator begin () const
+        {
+            return iterator {static_cast<node_ptr> (m_set->leftmost ()), m_set};
+        }
+
+        iterator end () const { return iterator {nullptr, m_set}; }
+
+        template <typename K = value_type> iterator find (const key_arg<K> &key) const
+        {
+            auto lb = lower_bound (key);
+            return (lb != end () && !m_set->compare (key, *lb) ? lb : end ());
+        }
+
+        template <typename K = value_type> bool contains (const key_arg<K> &key) const
+        {
+            return find (key) != end ();
+        }
+
+        template <typename K = value_type> iterator lower_bound (const key_arg<K> &key) const
+        {
+            return m_set->base_set::lower_bound (key);
+        }
+
+        template <typename K = value_type> iterator upper_bound (const key_arg<K> &key) const
+        {
+            return m_set->base_set::upper_bound (key);
+        }
+
+        iterator os_select (size_type rank) const { return m_set->base_do_set::os_select (rank); }
+
+        size_type get_rank_of (const iterator it) const
+        {
+            return m_set->base_do_set::get_rank_of (it);
+        }
+
+        template <typename K = value_type> size_type count_less (const key_arg<K> &key) const
+        {
+            return m_set->base_do_set::count_less (key);
+        }
+
+        template <typename K = value_type> size_type count_greater (const key_arg<K> &key) const
+        {
+            return m_set->base_do_set::count_greater (key);
+        }
+
+        template <typename K1 = value_type, typename K2 = K1>
+        size_type count_in_range (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+        {
+            return m_set->base_do_set::count_in_range (lo, hi);
+        }
+
+        template <typename K1 = value_type, typename K2 = K1>
+        auto aggregate (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+            requires base_do_set::augmented
+        {
+            return m_set->base_do_set::aggregate (lo, hi);
+        }
+
+        template <typename F>
+        iterator find_by_prefix (F pred) const
+            requires base_do_set::augmented
+        {
+            return m_set->base_do_set::find_by_prefix (pred);
+        }
+    };
+
+    read_only_view frozen_view () const { return read_only_view {*this}; }
+
+  protected:
+    void splay (base_node_ptr to_splay) const
+    {
+        splay_below (to_splay, base_set::root ()->m_parent);
+    }
+
+    // splays to_splay until it becomes a child of top, its ancestor or the header.
+    void splay_below (base_node_ptr to_splay, base_node_ptr top) const
+    {
+        assert (to_splay);
+        // every rotation lifts to_splay by one level
+        size_type depth = 0;
+        while ( to_splay->m_parent != top )
+        {
+            if ( to_splay->m_parent->m_parent != top )
+            {
+                auto to_rotate = to_splay->is_linear () ? to_splay->m_parent : to_splay;
+                to_rotate->template rotate_to_parent<node> ();
+                ++depth;
+            }
+            to_splay->template rotate_to_parent<node> ();
+            ++depth;
+        }
+        base_set::count (stat::splays);
+        base_set::count (stat::rotations, depth);
+        base_set::count (stat::splay_path_length, depth);
+    }
+
+    // Semi-splaying: a zig-zig step rotates only the parent and continues from it, zig-zag and
+    // zig steps are the same as in splay ().
+    void semi_splay (base_node_ptr to_splay) const
     {
-        assert (node);
-        while ( node != base_set::root () )
+        assert (to_splay);
+        size_type rotations = 0, depth = 0;
+        while ( to_splay != base_set::root () )
         {
-            if ( node->m_parent != base_set::root () )
+            if ( to_splay->m_parent == base_set::root () )
+            {
+                to_splay->template rotate_to_parent<node> ();
+                ++rotations;
+                ++depth;
+                break;
+            }
+            if ( to_splay->is_linear () )
             {
-                auto to_rotate = node->is_linear () ? node->m_parent : node;
-                to_rotate->rotate_to_parent ();
+                to_splay = to_splay->m_parent;
+                to_splay->template rotate_to_parent<node> ();
+                ++rotations;
             }
-            node->rotate_to_parent ();
+            else
+            {
+                to_splay->template rotate_to_parent<node> ();
+                to_splay->template rotate_to_parent<node> ();
+                rotations += 2;
+            }
+            depth += 2;
+        }
+        base_set::count (stat::splays);
+        base_set::count (stat::rotations, rotations);
+        base_set::count (stat::splay_path_length, depth);
+    }
+
+    // Restructuring after a bottom-up lookup or insert of the node, as the policy says. depth is
+    // the number of nodes the descent to it passed, which the caller counts on the way down.
+    void access (base_node_ptr to_access, size_type depth) const
+    {
+        if ( !to_access )
+            return;
+        if constexpr ( Splay_t::is_conditional )
+        {
+            if ( !m_policy.should_splay (depth, base_set::size ()) )
+                return;
         }
+        if constexpr ( Splay_t::is_semi )
+            semi_splay (to_access);
+        else
+            splay (to_access);
+    }
+
+    // Sleator-Tarjan top-down splay of the subtree rooted at to_splay. cmp (node) tells where the
+    // target is: < 0 in the left subtree, > 0 in the right one, 0 for the node itself. Nodes
+    // passed on the way down are hung on two spines whose sizes are collected during the
+    // descent and written back in one pass over each spine. Returns the new subtree root, its
+    // parent link is left to the caller, together with cmp of it, the last comparison made.
+    template <typename F>
+    std::pair<base_node_ptr, int> splay_top_down (base_node_ptr to_splay, F cmp) const
+    {
+        base_node assembly {};
+        base_node_ptr l = &assembly, r = &assembly;
+        size_type l_size = 0, r_size = 0;
+        size_type rotations = 0, depth = 0;
+
+        auto curr = to_splay;
+        auto c    = cmp (curr);
+        while ( c )
+        {
+            if ( c < 0 )
+            {
+                auto next = curr->m_left;
+                if ( !next )
+                    break;
+                auto c_next = cmp (next);
+                if ( c_next < 0 )
+                {
+                    curr->m_left = next->m_right;
+                    if ( curr->m_left )
+                        curr->m_left->m_parent = curr;
+                    next->m_right  = curr;
+                    curr->m_parent = next;
+                    node::update (curr);
+                    curr = next;
+                    c    = c_next;
+                    ++rotations;
+                    ++depth;
+                    next = curr->m_left;
+                    if ( !next )
+                        break;
+                    c_next = cmp (next);
+                }
+                r->m_left      = curr;
+                curr->m_parent = r;
+                r              = curr;
+                r_size += node::multiplicity (r) + node::size (r->m_right);
+                curr = next;
+                c    = c_next;
+                ++depth;
+            }
+            else
+            {
+                auto next = curr->m_right;
+                if ( !next )
+                    break;
+                auto c_next = cmp (next);
+                if ( c_next > 0 )
+                {
+                    curr->m_right = next->m_left;
+                    if ( curr->m_right )
+                        curr->m_right->m_parent = curr;
+                    next->m_left   = curr;
+                    curr->m_parent = next;
+                    node::update (curr);
+                    curr = next;
+                    c    = c_next;
+                    ++rotations;
+                    ++depth;
+                    next = curr->m_right;
+                    if ( !next )
+                        break;
+                    c_next = cmp (next);
+                }
+                l->m_right     = curr;
+                curr->m_parent = l;
+                l              = curr;
+                l_size += node::multiplicity (l) + node::size (l->m_left);
+                curr = next;
+                c    = c_next;
+                ++depth;
+            }
+        }
+
+        l_size += node::size (curr->m_left);
+        r_size += node::size (curr->m_right);
+        node::size_ref (curr) = l_size + r_size + node::multiplicity (curr);
+
+        l->m_right = nullptr;
+        r->m_left  = nullptr;
+        for ( auto spine = assembly.m_right; spine; spine = spine->m_right )
+        {
+            node::size_ref (spine) = l_size;
+            l_size -= node::size (spine->m_left) + node::multiplicity (spine);
+        }
+        for ( auto spine = assembly.m_left; spine; spine = spine->m_left )
+        {
+            node::size_ref (spine) = r_size;
+            r_size -= node::size (spine->m_right) + node::multiplicity (spine);
+        }
+
+        l->m_right = curr->m_left;
+        if ( l->m_right )
+            l->m_right->m_parent = l;
+        r->m_left = curr->m_right;
+        if ( r->m_left )
+            r->m_left->m_parent = r;
+        curr->m_left = assembly.m_right;
+        if ( curr->m_left )
+            curr->m_left->m_parent = curr;
+        curr->m_right = assembly.m_left;
+        if ( curr->m_right )
+            curr->m_right->m_parent = curr;
+        if constexpr ( base_do_set::augmented )
+        {
+            // aggregates are not subtractive, the spines are recomputed from their lower ends
+            for ( auto spine = l; spine != &assembly && spine != curr; spine = spine->m_parent )
+                node::update (spine);
+            for ( auto spine = r; spine != &assembly && spine != curr; spine = spine->m_parent )
+                node::update (spine);
+            node::update (curr);
+        }
+        base_set::count (stat::splays);
+        base_set::count (stat::rotations, rotations);
+        base_set::count (stat::splay_path_length, depth);
+        return {curr, c};
+    }
+
+    // Top-down splays the whole tree, which must not be empty. Returns the new root and cmp of
+    // it, so the caller need not compare with the root again.
+    template <typename F> std::pair<base_node_ptr, int> splay_root_top_down (F cmp) const
+    {
+        auto header            = base_set::root ()->m_parent;
+        auto [new_root, order] = splay_top_down (base_set::root (), cmp);
+        new_root->m_parent     = header;
+        base_set::root ()      = new_root;
+        return {new_root, order};
+    }
+
+    template <typename K> auto key_cmp (const K &key) const
+    {
+        return [this, &key] (base_node_ptr curr) {
+            return base_set::compare_three_way (key, static_cast<node_ptr> (curr)->m_value);
+        };
+    }
+
+    // moves the successor of the root to the root, returns nullptr if there is no successor.
+    base_node_ptr splay_root_successor () const
+    {
+        auto root = base_set::root ();
+        if ( !root->m_right )
+            return nullptr;
+        auto successor =
+            splay_top_down (root->m_right, [] (base_node_ptr) { return -1; }).first;
+        root->m_right       = successor;
+        successor->m_parent = root;
+        successor->template rotate_to_parent<node> ();
+        base_set::count (stat::rotations);
+        return successor;
+    }
+
+    template <typename K> base_node_ptr lower_bound_top_down (const K &key) const
+    {
+        if ( base_set::empty () )
+            return nullptr;
+        auto [root, order] = splay_root_top_down (key_cmp (key));
+        if ( order <= 0 )
+            return root;
+        return splay_root_successor ();
+    }
+
+    template <typename K> base_node_ptr upper_bound_top_down (const K &key) const
+    {
+        if ( base_set::empty () )
+            return nullptr;
+        auto [root, order] = splay_root_top_down (key_cmp (key));
+        if ( order < 0 )
+            return root;
+        return splay_root_successor ();
+    }
+
+    template <typename K> base_node_ptr find_top_down (const K &key) const
+    {
+        if ( base_set::empty () )
+            return nullptr;
+        auto [root, order] = splay_root_top_down (key_cmp (key));
+        return (order ? nullptr : root);
+    }
+
+    // the node is created first, its value is the key to splay by
+    template <typename... Args> base_node_ptr emplace_top_down (Args &&...args)
+    {
+        if ( base_set::empty () )
+            return base_set::emplace_value ([] (base_node_ptr) {}, [] (base_node_ptr) {},
+                                            std::forward<Args> (args)...);
+
+        base_node_ptr to_insert =
+            base_set::create_node (std::in_place, std::forward<Args> (args)...);
+        const auto &key = static_cast<node_ptr> (to_insert)->m_value;
+        base_node_ptr root {};
+        int c = 0;
+        try
+        {
+            std::tie (root, c) = splay_root_top_down (key_cmp (key));
+            if ( !c )
+                throw std::out_of_range ("Element already inserted");
+        }
+        catch ( ... )
+        {
+            base_set::destroy_node (to_insert);
+            throw;
+        }
+
+        auto header = root->m_parent;
+        if ( c < 0 )
+        {
+            to_insert->m_left  = root->m_left;
+            to_insert->m_right = root;
+            root->m_left       = nullptr;
+        }
+        else
+        {
+            to_insert->m_right = root->m_right;
+            to_insert->m_left  = root;
+            root->m_right      = nullptr;
+        }
+        if ( to_insert->m_left )
+            to_insert->m_left->m_parent = to_insert;
+        if ( to_insert->m_right )
+            to_insert->m_right->m_parent = to_insert;
+        node::update (root);
+        node::update (to_insert);
+
+        to_insert->m_parent = header;
+        base_set::root ()   = to_insert;
+        base_set::inc_size ();
+        if ( !to_insert->m_left )
+            base_set::leftmost () = to_insert;
+        if ( !to_insert->m_right )
+            base_set::rightmost () = to_insert;
+        return to_insert;
+    }
+
+    // erases the root, joining its subtrees by bringing the maximum of the left one up.
+    void erase_root_top_down ()
+    {
+        if ( base_set::size () == 1 )
+        {
+            base_set::reset_header_struct ();
+            return;
+        }
+
+        auto to_erase = base_set::root ();
+        auto header   = to_erase->m_parent;
+        base_node_ptr new_root {};
+        if ( !to_erase->m_left )
+        {
+            new_root              = to_erase->m_right;
+            base_set::leftmost () = new_root->minimum ();
+        }
+        else
+        {
+            new_root = splay_top_down (to_erase->m_left, [] (base_node_ptr) { return 1; }).first;
+            new_root->m_right = to_erase->m_right;
+            if ( new_root->m_right )
+                new_root->m_right->m_parent = new_root;
+            else
+                base_set::rightmost () = new_root;
+            node::update (new_root);
+        }
+        new_root->m_parent = header;
+        base_set::root ()  = new_root;
+        base_set::decr_size ();
+        base_set::destroy_node (to_erase);
+    }
+
+    // return the bound moved to the root or nullptr if there is no such element.
+    template <typename K> base_node_ptr splay_lower_bound (const K &key) const
+    {
+        if constexpr ( Splay_t::is_top_down )
+            return lower_bound_top_down (key);
+        size_type depth = 0;
+        auto lb = base_set::lower_bound_base (key, [&depth] (base_node_ptr) { ++depth; });
+        access (lb, depth);
+        return lb;
+    }
+
+    template <typename K> base_node_ptr splay_upper_bound (const K &key) const
+    {
+        if constexpr ( Splay_t::is_top_down )
+            return upper_bound_top_down (key);
+        size_type depth = 0;
+        auto ub = base_set::upper_bound_base (key, [&depth] (base_node_ptr) { ++depth; });
+        access (ub, depth);
+        return ub;
     }
 
     void merge (base_node_ptr left, base_node_ptr right)
@@ -69,24 +538,43 @@ struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
             base_set::root () = std::move (left_max->m_parent->m_left);
         else
             base_set::root () = std::move (left_max->m_parent->m_right);
-        node::size_ref (left_max) =
-            node::size (left_max->m_left) + node::size (left_max->m_right) + 1;
+        node::update (left_max);
     }
 
   public:
-    void insert (const value_type &key) override
+    void insert (const value_type &key) { emplace (key); }
+
+    void insert (value_type &&key) { emplace (std::move (key)); }
+
+    template <typename... Args> void emplace (Args &&...args)
     {
-        auto to_insert_uptr = std::make_unique<node> (key);
-        auto to_insert      = to_insert_uptr.get ();
-        base_set::insert_node_to_nodes (std::move (to_insert_uptr));
-        base_set::insert_base (
-            to_insert, [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size++; },
-            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; });
-        splay (to_insert);
+        if constexpr ( Splay_t::is_top_down )
+        {
+            emplace_top_down (std::forward<Args> (args)...);
+            return;
+        }
+        size_type depth = 0;
+        auto to_insert  = base_set::emplace_value (
+            [&depth] (base_node_ptr node) {
+                static_cast<node_ptr> (node)->m_size++;
+                ++depth;
+            },
+            [] (base_node_ptr node) { static_cast<node_ptr> (node)->m_size--; },
+            std::forward<Args> (args)...);
+        if constexpr ( base_do_set::augmented )
+            base_do_set::update_up (to_insert);
+        access (to_insert, depth);
     }
 
-    void erase (const value_type &key) override
+    template <typename K = value_type> void erase (const key_arg<K> &key)
     {
+        if constexpr ( Splay_t::is_top_down )
+        {
+            if ( !find_top_down (key) )
+                throw std::out_of_range ("Element is not presented");
+            erase_root_top_down ();
+            return;
+        }
         auto [to_erase, prev, prev_greater] =
             base_set::trav_bin_search (key, [] (base_node_ptr) {});
         if ( !to_erase )
@@ -94,43 +582,270 @@ struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
         erase_splay (to_erase);
     }
 
-    void erase (iterator it) override { erase_splay (it.m_node); }
+    void erase (iterator it)
+    {
+        if constexpr ( Splay_t::is_top_down )
+        {
+            find_top_down (*it);
+            erase_root_top_down ();
+        }
+        else
+            erase_splay (it.m_node);
+    }
+
+    // Moves the elements not less than key to the returned set, which shares the comparator and
+    // the node storage with this one. O(log n) amortized.
+    template <typename K = value_type> splay_dynamic_order_set split (const key_arg<K> &key)
+    {
+        splay_dynamic_order_set res;
+        res.base_set::share_storage (*this);
+        // a stateful policy gets a fresh state, the two halves must not replay the same choices
+        if constexpr ( requires { m_policy.fork (); } )
+            res.m_policy = m_policy.fork ();
+        else
+            res.m_policy = m_policy;
+        auto lb = base_set::lower_bound_base (key);
+        if ( !lb )
+            return res;
+
+        splay (lb);
+        auto left      = std::exchange (lb->m_left, nullptr);
+        auto left_size = node::size (left);
+        auto leftmost  = base_set::leftmost ();
+        node::update (lb);
+        res.base_set::attach_tree (lb, lb, base_set::rightmost (), base_set::size () - left_size);
+        base_set::forget_tree ();
+        if ( left )
+        {
+            // splaying the maximum pays for the walk to it
+            base_set::attach_tree (left, leftmost, left->maximum (), left_size);
+            splay (base_set::rightmost ());
+        }
+        return res;
+    }
 
-    iterator find (const value_type key) override
+    // Moves all the elements of other, which must be greater than every element of this set,
+    // to this set. O(log n) amortized if the sets share the node storage, e.g. other comes from
+    // split (), or if this set can take over the storage of other. Otherwise the elements are
+    // copied in O(m).
+    void join (splay_dynamic_order_set &other)
     {
-        auto [found, prev, prev_greater] = base_set::trav_bin_search (key, [] (base_node_ptr) {});
+        if ( other.empty () )
+            return;
+        check_join_order (other);
+        if ( !base_set::adopt_storage (other) )
+        {
+            for ( const auto &key : other )
+                insert (key);
+            other.clear ();
+            return;
+        }
+        attach_joined (other);
+    }
+
+    void join (splay_dynamic_order_set &&other) { join (other); }
+
+    // Erases the elements of [first, last) and returns their number. O(log n) amortized to cut
+    // the range out of the tree plus the time to free its nodes.
+    size_type erase (iterator first, iterator last)
+    {
+        if ( first == last )
+            return 0;
+        if ( first == base_set::begin () && last == base_set::end () )
+        {
+            auto n = base_set::size ();
+            base_set::clear ();
+            return n;
+        }
+
+        // the range is cut between the predecessor of first and last, which are splayed to the
+        // root and below it. Splaying last and first first pays for the descents to them.
+        base_node_ptr first_node = first.m_node, last_node = last.m_node, removed {};
+        if ( last_node )
+            splay (last_node);
+        splay (first_node);
+        auto pred = (first_node->m_left ? first_node->m_left->maximum () : nullptr);
+        if ( !pred )
+        {
+            splay (last_node);
+            removed               = std::exchange (last_node->m_left, nullptr);
+            base_set::leftmost () = last_node;
+            node::update (last_node);
+        }
+        else if ( !last_node )
+        {
+            splay (pred);
+            removed               = std::exchange (pred->m_right, nullptr);
+            base_set::rightmost () = pred;
+            node::update (pred);
+        }
+        else
+        {
+            splay (pred);
+            splay_below (last_node, pred);
+            removed = std::exchange (last_node->m_left, nullptr);
+            node::update (last_node);
+            node::update (pred);
+        }
+
+        auto n = node::size (removed);
+        base_set::destroy_subtree (removed);
+        base_set::set_size (base_set::size () - n);
+        return n;
+    }
+
+    // Erases the elements in [lo, hi] and returns their number, 0 if hi < lo.
+    template <typename K1 = value_type, typename K2 = K1>
+    size_type erase (const key_arg<K1> &lo, const key_arg<K2> &hi)
+    {
+        if ( base_set::compare (hi, lo) )
+            return 0;
+        return erase (iterator {static_cast<node_ptr> (base_set::lower_bound_base (lo)), this},
+                      iterator {static_cast<node_ptr> (base_set::upper_bound_base (hi)), this});
+    }
+
+    template <typename K = value_type> iterator find (const key_arg<K> &key)
+    {
+        if constexpr ( Splay_t::is_top_down )
+            return iterator {static_cast<node_ptr> (find_top_down (key)), this};
+        size_type depth = 0;
+        auto [found, prev, prev_greater] =
+            base_set::trav_bin_search (key, [&depth] (base_node_ptr) { ++depth; });
         if ( !found )
             return base_set::end ();
-        splay (found);
+        access (found, depth);
         return iterator {static_cast<node_ptr> (found), this};
     }
 
-    const_iterator find (const value_type key) const override
+    template <typename K = value_type> const_iterator find (const key_arg<K> &key) const
     {
-        auto [found, prev, prev_greater] = base_set::trav_bin_search (key, [] (base_node_ptr) {});
+        if constexpr ( Splay_t::is_top_down )
+            return const_iterator {static_cast<node_ptr> (find_top_down (key)), this};
+        size_type depth = 0;
+        auto [found, prev, prev_greater] =
+            base_set::trav_bin_search (key, [&depth] (base_node_ptr) { ++depth; });
         if ( !found )
             return base_set::end ();
-        splay (found);
+        access (found, depth);
         return const_iterator {static_cast<node_ptr> (found), this};
     }
 
-    iterator lower_bound (const value_type &key) const override
+    template <typename K = value_type> iterator lower_bound (const key_arg<K> &key) const
     {
-        auto lb = base_set::lower_bound_base (key);
-        if ( lb )
-            splay (lb);
-        return iterator {static_cast<node_ptr> (lb), this};
+        return iterator {static_cast<node_ptr> (splay_lower_bound (key)), this};
+    }
+
+    template <typename K = value_type> iterator upper_bound (const key_arg<K> &key) const
+    {
+        return iterator {static_cast<node_ptr> (splay_upper_bound (key)), this};
     }
 
-    iterator upper_bound (const value_type &key) const override
+    // With a policy that leaves the bound somewhere below the root its rank is found by a walk
+    // to the root instead.
+    template <typename K = value_type> size_type count_less (const key_arg<K> &key) const
     {
-        auto ub = base_set::upper_bound_base (key);
-        if ( ub )
-            splay (ub);
-        return iterator {static_cast<node_ptr> (ub), this};
+        auto lb = splay_lower_bound (key);
+        if ( !lb )
+            return base_set::size ();
+        if constexpr ( brings_to_root )
+            return node::size (lb->m_left);
+        return base_do_set::get_rank_of (lb) - 1;
+    }
+
+    template <typename K = value_type> size_type count_greater (const key_arg<K> &key) const
+    {
+        auto ub = splay_upper_bound (key);
+        if ( !ub )
+            return 0;
+        if constexpr ( brings_to_root )
+            return node::size (ub->m_right) + node::multiplicity (ub);
+        return base_set::size () - base_do_set::get_rank_of (ub) + 1;
+    }
+
+    // Once the lower bound of lo is splayed to the root, everything in range lies in the root and
+    // its right subtree, which is counted with one descent towards hi. Otherwise the elements not
+    // greater than hi are counted from the root and the ones before the bound are subtracted.
+    template <typename K1 = value_type, typename K2 = K1>
+    size_type count_in_range (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+    {
+        if ( base_set::compare (hi, lo) )
+            return 0;
+        auto lb = splay_lower_bound (lo);
+        if ( !lb || base_set::compare (hi, static_cast<node_ptr> (lb)->m_value) )
+            return 0;
+        if constexpr ( brings_to_root )
+            return base_do_set::count_not_greater (lb->m_right, hi) + node::multiplicity (lb);
+        return base_do_set::count_not_greater (base_set::root (), hi) -
+               base_do_set::get_rank_of (lb) + 1;
+    }
+
+    // Like count_in_range: with the lower bound of lo at the root the range is the root and a
+    // prefix of its right subtree.
+    template <typename K1 = value_type, typename K2 = K1>
+    auto aggregate (const key_arg<K1> &lo, const key_arg<K2> &hi) const
+        requires base_do_set::augmented
+    {
+        using augment = typename node::augment_type;
+        if ( base_set::compare (hi, lo) )
+            return augment::identity ();
+        auto lb = splay_lower_bound (lo);
+        if ( !lb || base_set::compare (hi, static_cast<node_ptr> (lb)->m_value) )
+            return augment::identity ();
+        if constexpr ( brings_to_root )
+        {
+            auto rest = base_do_set::fold_prefix (lb->m_right, base_do_set::not_greater (hi));
+            return augment::combine (node::of (lb), rest);
+        }
+        return base_do_set::aggregate (lo, hi);
+    }
+
+    // the found element is splayed, which pays for the descent
+    template <typename F>
+    iterator find_by_prefix (F pred) const
+        requires base_do_set::augmented
+    {
+        size_type depth = 0;
+        auto found = base_do_set::search_prefix (pred, [&depth] (base_node_ptr) { ++depth; });
+        access (found, depth);
+        return iterator {static_cast<node_ptr> (found), this};
     }
 
   protected:
+    // throws unless every element of other, which must not be empty, is greater than the ones
+    // of this set
+    void check_join_order (const splay_dynamic_order_set &other) const
+    {
+        if ( !base_set::empty () &&
+             !base_set::compare (static_cast<node_ptr> (base_set::rightmost ())->m_value,
+                                 static_cast<node_ptr> (other.base_set::leftmost ())->m_value) )
+            throw std::out_of_range ("Joined elements must be greater than the set elements");
+    }
+
+    // The second half of join: other, checked and not empty, already shares the node storage
+    // of this set.
+    void attach_joined (splay_dynamic_order_set &other)
+    {
+        auto other_root      = other.base_set::root ();
+        auto other_leftmost  = other.base_set::leftmost ();
+        auto other_rightmost = other.base_set::rightmost ();
+        auto other_size      = other.base_set::size ();
+        other.base_set::forget_tree ();
+        if ( base_set::empty () )
+        {
+            base_set::attach_tree (other_root, other_leftmost, other_rightmost, other_size);
+            return;
+        }
+
+        // the maximum at the root has no right subtree, other becomes it
+        auto max = base_set::rightmost ();
+        splay (max);
+        max->m_right         = other_root;
+        other_root->m_parent = max;
+        node::update (max);
+        base_set::rightmost () = other_rightmost;
+        base_set::set_size (base_set::size () + other_size);
+    }
+
     void erase_splay (base_node_ptr to_erase)
     {
         assert (to_erase);
@@ -155,14 +870,19 @@ struct splay_dynamic_order_set : public dynamic_order_set<T, Compare_t>
                 merge (to_erase->m_left, to_erase->m_right);
             }
             base_set::decr_size ();
+            base_set::destroy_node (to_erase);
         }
         else
-        {
             base_set::reset_header_struct ();
-        }
-        base_set::erase_node_from_nodes (to_erase);
     }
 };
 
+// Order statistic splay set whose nodes also keep an Augment_t aggregate of their subtrees,
+// see augmentation.hpp
+template <typename T, class Augment_t, class Compare_t = std::less<T>,
+          class Alloc_t = node_arena<T>, class Splay_t = bottom_up_splay>
+using augmented_splay_set =
+    splay_dynamic_order_set<T, Compare_t, Alloc_t, Splay_t, augmented_node<T, Augment_t>>;
+
 }   // namespace containers
 }   // namespace red
\ No newline at end of file
@@ -0,0 +1,312 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// order statistic splay multiset keeping one node per distinct value
+
+#pragma once
+
+#include "splay_dynamic_order_set.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace red
+{
+namespace containers
+{
+
+// m_count copies of m_value, a node built in one go by assign
+template <typename T> struct multiset_run
+{
+    T m_value;
+    std::size_t m_count;
+};
+
+// A node standing for m_count equal elements. The subtree size counts every copy, so ranks and
+// range counts include the duplicates.
+template <typename T> struct multiset_node : public dynamic_order_set_node<T>
+{
+    using base = dynamic_order_set_node<T>;
+    using typename base::base_node;
+    using typename base::base_node_ptr;
+    using typename base::size_type;
+    using typename base::value_type;
+
+    size_type m_count = 1;
+
+    template <typename... Args>
+    multiset_node (std::in_place_t tag, Args &&...args) : base {tag, std::forward<Args> (args)...}
+    {
+    }
+
+    multiset_node (std::in_place_t tag, multiset_run<T> &&run)
+        : base {tag, std::move (run.m_value)}, m_count {run.m_count}
+    {
+    }
+
+    static size_type multiplicity (const base_node *node)
+    {
+        return static_cast<const multiset_node *> (node)->m_count;
+    }
+
+    static size_type &multiplicity_ref (base_node_ptr node)
+    {
+        return static_cast<multiset_node *> (node)->m_count;
+    }
+
+    // the counter belongs to the value, not to the place in the tree
+    static void swap_values (multiset_node &lhs, multiset_node &rhs)
+    {
+        base::swap_values (lhs, rhs);
+        std::swap (lhs.m_count, rhs.m_count);
+    }
+
+    static void update (base_node_ptr node)
+    {
+        base::size_ref (node) =
+            base::size (node->m_left) + base::size (node->m_right) + multiplicity (node);
+    }
+
+    // new_top takes the place of old_top, so it inherits its size.
+    static void after_rotate (base_node_ptr old_top, base_node_ptr new_top)
+    {
+        base::size_ref (new_top) = base::size_ref (old_top);
+        update (old_top);
+    }
+};
+
+// Multiset on top of splay_dynamic_order_set. Equal elements share one node with a counter, so
+// memory stays at one node per distinct value and duplicates cost no comparisons. size (), ranks,
+// os_select and the count_* queries count every copy, iteration visits each distinct value once
+// and multiplicity () tells how many copies it has.
+template <typename T, class Compare_t = std::less<T>, class Alloc_t = node_arena<T>,
+          class Splay_t = bottom_up_splay>
+struct splay_order_multiset
+    : public splay_dynamic_order_set<T, Compare_t, Alloc_t, Splay_t, multiset_node<T>>
+{
+  private:
+    using base_splay_set =
+        splay_dynamic_order_set<T, Compare_t, Alloc_t, Splay_t, multiset_node<T>>;
+    using typename base_splay_set::base_do_set;
+    using typename base_splay_set::base_node_ptr;
+    using typename base_splay_set::base_set;
+    using typename base_splay_set::node;
+    using typename base_splay_set::node_ptr;
+
+  public:
+    using typename base_splay_set::size_type;
+    using typename base_splay_set::value_type;
+
+    template <typename K> using key_arg = typename base_splay_set::template key_arg<K>;
+
+    using typename base_splay_set::const_iterator;
+    using typename base_splay_set::iterator;
+
+    splay_order_multiset () = default;
+
+    explicit splay_order_multiset (const Compare_t &comp) : base_splay_set {comp} {}
+
+    template <std::input_iterator It>
+    splay_order_multiset (It first, It last, const Compare_t &comp = Compare_t {})
+        : base_splay_set {comp}
+    {
+        assign (first, last);
+    }
+
+    splay_order_multiset (std::initializer_list<value_type> ilist,
+                          const Compare_t &comp = Compare_t {})
+        : splay_order_multiset (ilist.begin (), ilist.end (), comp)
+    {
+    }
+
+    void insert (const value_type &key) { insert_copies (key, 1); }
+
+    void insert (value_type &&key) { insert_copies (std::move (key), 1); }
+
+    template <std::input_iterator It> void insert (It first, It last)
+    {
+        for ( ; first != last; ++first )
+            insert (*first);
+    }
+
+    template <typename... Args> void emplace (Args &&...args)
+    {
+        insert_copies (value_type (std::forward<Args> (args)...), 1);
+    }
+
+    // Replaces the contents with the elements of [first, last), duplicates included. The elements
+    // are sorted unless a forward range already is, every run of equal ones becomes one node and
+    // the tree is built perfectly balanced in O(n).
+    template <std::input_iterator It> void assign (It first, It last)
+    {
+        auto less = [this] (const value_type &lhs, const value_type &rhs) {
+            return base_set::compare (lhs, rhs);
+        };
+        if constexpr ( std::forward_iterator<It> )
+        {
+            if ( std::is_sorted (first, last, less) )
+            {
+                build_runs (first, last);
+                return;
+            }
+        }
+        std::vector<value_type> keys (first, last);
+        std::sort (keys.begin (), keys.end (), less);
+        build_runs (std::make_move_iterator (keys.begin ()),
+                    std::make_move_iterator (keys.end ()));
+    }
+
+    void assign (std::initializer_list<value_type> ilist) { assign (ilist.begin (), ilist.end ()); }
+
+    // number of copies of key, 0 if there are none
+    template <typename K = value_type> size_type count (const key_arg<K> &key) const
+    {
+        auto found = base_splay_set::find (key);
+        return (found == base_set::end () ? 0 : multiplicity (found));
+    }
+
+    size_type multiplicity (iterator it) const { return node::multiplicity (it.m_node); }
+
+    size_type multiplicity (const_iterator it) const { return node::multiplicity (it.m_node); }
+
+    using base_splay_set::erase;
+
+    // Erases all the copies of key and returns their number.
+    template <typename K = value_type> size_type erase (const key_arg<K> &key)
+    {
+        auto found = base_splay_set::find (key);
+        if ( found == base_set::end () )
+            throw std::out_of_range ("Element is not presented");
+        auto copies = multiplicity (found);
+        remove_copies (found.m_node, copies - 1);
+        base_splay_set::erase (found);
+        return copies;
+    }
+
+    // erases one copy of the element
+    void erase (iterator it)
+    {
+        if ( multiplicity (it) == 1 )
+        {
+            base_splay_set::erase (it);
+            return;
+        }
+        base_splay_set::access (it.m_node, remove_copies (it.m_node, 1));
+    }
+
+    template <typename K = value_type> splay_order_multiset split (const key_arg<K> &key)
+    {
+        splay_order_multiset res;
+        static_cast<base_splay_set &> (res) = base_splay_set::split (key);
+        return res;
+    }
+
+    // The nodes of other are moved over with their counters if the storage can be shared, see
+    // splay_dynamic_order_set::join. Otherwise they are copied into the storage of this set first.
+    // The order is checked before anything is moved.
+    void join (splay_order_multiset &other)
+    {
+        if ( other.empty () )
+            return;
+        base_splay_set::check_join_order (other);
+        if ( base_set::adopt_storage (other) )
+        {
+            base_splay_set::attach_joined (other);
+            return;
+        }
+        splay_order_multiset copy;
+        copy.base_set::share_storage (*this);
+        for ( auto pos = other.begin (); pos != other.end (); ++pos )
+            copy.insert_copies (*pos, other.multiplicity (pos));
+        base_splay_set::attach_joined (copy);
+        other.clear ();
+    }
+
+    void join (splay_order_multiset &&other) { join (other); }
+
+  private:
+    // Builds the tree from the sorted range, runs of equal elements are collapsed into one node.
+    // The range is walked twice, a move_iterator over a vector will do.
+    template <typename It> void build_runs (It first, It last)
+    {
+        std::vector<multiset_run<value_type>> runs;
+        size_type total = 0;
+        while ( first != last )
+        {
+            auto run_end = std::find_if (std::next (first), last, [this, &first] (const auto &key) {
+                return base_set::compare (*first, key);
+            });
+            auto count   = static_cast<size_type> (std::distance (first, run_end));
+            runs.push_back ({*first, count});
+            total += count;
+            first = run_end;
+        }
+        base_set::build_balanced (std::make_move_iterator (runs.begin ()),
+                                  static_cast<std::ptrdiff_t> (runs.size ()));
+        base_set::set_size (total);
+    }
+
+    template <typename V> void insert_copies (V &&value, size_type copies)
+    {
+        if constexpr ( Splay_t::is_top_down )
+        {
+            // a new value is inserted next to the root left by the failed lookup
+            auto found = base_splay_set::find_top_down (value);
+            if ( !found )
+            {
+                found = base_splay_set::emplace_top_down (std::forward<V> (value));
+                --copies;
+            }
+            add_copies (found, copies);
+        }
+        else
+        {
+            auto [found, prev, prev_greater] =
+                base_set::trav_bin_search (value, [] (base_node_ptr) {});
+            if ( !found )
+            {
+                found = base_set::create_node (std::in_place, std::forward<V> (value));
+                node::multiplicity_ref (found) = 0;
+                node::size_ref (found)         = 0;
+                base_set::link_leaf (found, prev, prev_greater);
+            }
+            base_splay_set::access (found, add_copies (found, copies));
+        }
+    }
+
+    // Changes the counter of the node together with the sizes on its path to the root. Returns
+    // the depth of the node, which the walk up gives for free.
+    size_type add_copies (base_node_ptr target, size_type copies)
+    {
+        node::multiplicity_ref (target) += copies;
+        size_type depth = 0;
+        for ( auto curr = target; curr->m_parent; curr = curr->m_parent, ++depth )
+            node::size_ref (curr) += copies;
+        base_set::set_size (base_set::size () + copies);
+        return depth - 1;
+    }
+
+    size_type remove_copies (base_node_ptr target, size_type copies)
+    {
+        node::multiplicity_ref (target) -= copies;
+        size_type depth = 0;
+        for ( auto curr = target; curr->m_parent; curr = curr->m_parent, ++depth )
+            node::size_ref (curr) -= copies;
+        base_set::set_size (base_set::size () - copies);
+        return depth - 1;
+    }
+};
+
+}   // namespace containers
+}   // namespace red
@@ -0,0 +1,121 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// splaying policies for splay_dynamic_order_set
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace red
+{
+namespace containers
+{
+
+// A policy tells splay_dynamic_order_set how a lookup (find, lower_bound, upper_bound, the
+// count_* queries) and an insert restructure the tree:
+//     is_top_down     - the Sleator-Tarjan top-down engine instead of the bottom-up one
+//     is_semi         - semi-splaying: the accessed node is only brought about halfway up
+//     is_conditional  - should_splay (depth, size) decides whether the node is splayed at all,
+//                       depth is the number of nodes the descent passed, counted on the way down
+// Erase always splays fully: it needs the node at the root to unlink it.
+
+// descend to the requested node first, then rotate it up to the root following parent links.
+struct bottom_up_splay
+{
+    static constexpr bool is_top_down    = false;
+    static constexpr bool is_semi        = false;
+    static constexpr bool is_conditional = false;
+
+    static constexpr bool should_splay (std::size_t, std::size_t) { return true; }
+};
+
+// Sleator-Tarjan top-down splaying: the tree is restructured during the single descent, parent
+// links are only written, never followed.
+struct top_down_splay
+{
+    static constexpr bool is_top_down    = true;
+    static constexpr bool is_semi        = false;
+    static constexpr bool is_conditional = false;
+
+    static constexpr bool should_splay (std::size_t, std::size_t) { return true; }
+};
+
+// Semi-splaying (Sleator-Tarjan): in the zig-zig case only the parent is rotated and splaying
+// goes on from it, so about half the rotations are done and the depth of every node on the path
+// is still roughly halved. Cheaper than full splaying when accesses do not repeat soon.
+struct semi_splay
+{
+    static constexpr bool is_top_down    = false;
+    static constexpr bool is_semi        = true;
+    static constexpr bool is_conditional = false;
+
+    static constexpr bool should_splay (std::size_t, std::size_t) { return true; }
+};
+
+// Splays only the nodes whose descent passed more than m_factor * log2 (n) nodes. Nodes that are
+// reasonably close to the root are left in place, so a balanced tree under uniform lookups stays
+// as it is, while long paths left by sequential inserts are still shortened.
+struct depth_threshold_splay
+{
+    static constexpr bool is_top_down    = false;
+    static constexpr bool is_semi        = false;
+    static constexpr bool is_conditional = true;
+
+    double m_factor = 2.0;
+
+    bool should_splay (std::size_t depth, std::size_t size) const
+    {
+        return static_cast<double> (depth) > m_factor * static_cast<double> (std::bit_width (size));
+    }
+};
+
+// Splays with probability m_probability. The expected restructuring cost drops proportionally
+// while frequently accessed nodes still make their way to the top.
+struct randomized_splay
+{
+    static constexpr bool is_top_down    = false;
+    static constexpr bool is_semi        = false;
+    static constexpr bool is_conditional = true;
+
+    double m_probability  = 0.5;
+    std::uint64_t m_state = 0x9e3779b97f4a7c15;
+
+    bool should_splay (std::size_t, std::size_t)
+    {
+        // the top 53 bits make a uniform double in [0, 1)
+        return static_cast<double> (next () >> 11) * 0x1p-53 < m_probability;
+    }
+
+    // Same probability, but a stream independent of this one: its seed is the splitmix64 hash
+    // of the next state of this stream. Used for the set split off by split ().
+    randomized_splay fork ()
+    {
+        auto z = next ();
+        z      = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z      = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        z ^= z >> 31;
+        return {m_probability, z ? z : 0x9e3779b97f4a7c15};
+    }
+
+  private:
+    // xorshift64
+    std::uint64_t next ()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+};
+
+}   // namespace containers
+}   // namespace red
@@ -32,19 +32,68 @@ struct dl_binary_tree_node_base
     dl_binary_tree_node_base *m_left   = nullptr;
     dl_binary_tree_node_base *m_right  = nullptr;
 
-    virtual ~dl_binary_tree_node_base () {};
-
-    virtual dl_binary_tree_node_base *rotate_left () { return rotate_left_base (); }
-
-    virtual dl_binary_tree_node_base *rotate_right () { return rotate_right_base (); }
-
     bool is_left_child () const { return (m_parent ? this == m_parent->m_left : false); }
 
     bool is_linear () const { return m_parent && (is_left_child () == m_parent->is_left_child ()); }
 
-    dl_binary_tree_node_base *rotate_left_base ();
+    dl_binary_tree_node_base *rotate_left_base ()
+    {
+        auto node       = this;
+        auto parent     = this->m_parent;
+        auto rchild_ptr = node->m_right;
+        node->m_right   = rchild_ptr->m_left;
+        if ( node->m_right )
+            node->m_right->m_parent = node;
+
+        rchild_ptr->m_parent = parent;
+        if ( parent )
+        {
+            rchild_ptr->m_left = node;
+            if ( node->is_left_child () )
+                parent->m_left = rchild_ptr;
+            else
+                parent->m_right = rchild_ptr;
+        }
+        node->m_parent = rchild_ptr;
+        return rchild_ptr;
+    }
 
-    dl_binary_tree_node_base *rotate_right_base ();
+    dl_binary_tree_node_base *rotate_right_base ()
+    {
+        auto node       = this;
+        auto parent     = this->m_parent;
+        auto lchild_ptr = node->m_left;
+        node->m_left    = lchild_ptr->m_right;
+        if ( node->m_left )
+            node->m_left->m_parent = node;
+        lchild_ptr->m_parent = parent;
+        if ( parent )
+        {
+            lchild_ptr->m_right = node;
+            if ( node->is_left_child () )
+                parent->m_left = lchild_ptr;
+            else
+                parent->m_right = lchild_ptr;
+        }
+        node->m_parent = lchild_ptr;
+        return lchild_ptr;
+    }
+
+    // Augmented rotations. Node_t::after_rotate (old_top, new_top) restores the data of the two
+    // nodes whose subtrees have changed, so there is no need in virtual dispatch.
+    template <typename Node_t> dl_binary_tree_node_base *rotate_left ()
+    {
+        auto rchild = rotate_left_base ();
+        Node_t::after_rotate (this, rchild);
+        return rchild;
+    }
+
+    template <typename Node_t> dl_binary_tree_node_base *rotate_right ()
+    {
+        auto lchild = rotate_right_base ();
+        Node_t::after_rotate (this, lchild);
+        return lchild;
+    }
 
     dl_binary_tree_node_base *successor () { return successor_base (); }
 
@@ -172,12 +221,12 @@ struct dl_binary_tree_node_base
         return node;
     };
 
-    dl_binary_tree_node_base *rotate_to_parent ()
+    template <typename Node_t> dl_binary_tree_node_base *rotate_to_parent ()
     {
         if ( is_left_child () )
-            return m_parent->rotate_right ();
+            return m_parent->template rotate_right<Node_t> ();
         else
-            return m_parent->rotate_left ();
+            return m_parent->template rotate_left<Node_t> ();
     }
 };
 
@@ -190,7 +239,7 @@ template <typename T> struct set_node : public dl_binary_tree_node_base
 
     value_type m_value {};
 
-    static const value_type value (const_base_node_ptr base_ptr)
+    static const value_type &value (const_base_node_ptr base_ptr)
     {
         return static_cast<const set_node<value_type> *> (base_ptr)->m_value;
     }
@@ -200,7 +249,20 @@ template <typename T> struct set_node : public dl_binary_tree_node_base
         return static_cast<set_node<value_type> *> (base_ptr)->m_value;
     }
 
-    set_node (T val) : m_value {val} {}
+    // the value is constructed in place from args
+    template <typename... Args>
+    set_node (std::in_place_t, Args &&...args) : m_value (std::forward<Args> (args)...)
+    {
+    }
+
+    // no augmentation
+    static void after_rotate (base_node_ptr, base_node_ptr) {}
+
+    static void update (base_node_ptr) {}
+
+    // Exchanges what belongs to the values of two nodes when they trade places in the tree.
+    // Nodes keeping more data about their value than m_value extend it.
+    static void swap_values (set_node &lhs, set_node &rhs) { std::swap (lhs.m_value, rhs.m_value); }
 };
 
 template <typename T> struct dynamic_order_set_node : public set_node<T>
@@ -213,7 +275,11 @@ template <typename T> struct dynamic_order_set_node : public set_node<T>
 
     size_type m_size = 1;
 
-    dynamic_order_set_node (const value_type value) : set_node<T> {value} {}
+    template <typename... Args>
+    dynamic_order_set_node (std::in_place_t tag, Args &&...args)
+        : set_node<T> {tag, std::forward<Args> (args)...}
+    {
+    }
 
     static size_type size (base_node_ptr base_ptr)
     {
@@ -227,20 +293,21 @@ template <typename T> struct dynamic_order_set_node : public set_node<T>
 
     size_type set_size (size_type size) { return m_size = size; }
 
-    base_node_ptr rotate_left () override
+    // Number of elements the node stands for. Subtree sizes, ranks and unlinking count a node as
+    // this many elements, so m_size is the sum of the multiplicities in the subtree. A set node is
+    // one element, multiset_node (splay_order_multiset.hpp) keeps a counter instead.
+    static size_type multiplicity (const base_node *) { return 1; }
+
+    // new_top takes the place of old_top, so it inherits its size.
+    static void after_rotate (base_node_ptr old_top, base_node_ptr new_top)
     {
-        auto rchild = static_cast<dynamic_order_set_node *> (base_node::rotate_left_base ());
-        rchild->m_size             = m_size;
-        m_size                     = 1 + size (base_node::m_left) + size (base_node::m_right);
-        return rchild;
+        size_ref (new_top) = size_ref (old_top);
+        update (old_top);
     }
 
-    base_node_ptr rotate_right () override
+    static void update (base_node_ptr base_ptr)
     {
-        auto lchild = static_cast<dynamic_order_set_node *> (base_node::rotate_right_base ());
-        lchild->m_size             = m_size;
-        m_size                     = 1 + size (base_node::m_left) + size (base_node::m_right);
-        return lchild;
+        size_ref (base_ptr) = 1 + size (base_ptr->m_left) + size (base_ptr->m_right);
     }
 };
 
@@ -0,0 +1,102 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// optional counters of the work done by a tree
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace red
+{
+namespace containers
+{
+
+// Counted only when SPLAY_TREE_STATS is defined (the SPLAY_TREE_STATS CMake option), otherwise
+// every field stays 0 and the counting compiles to nothing.
+struct tree_stats
+{
+    std::size_t comparisons       = 0;   // calls of the comparator
+    std::size_t rotations         = 0;   // single rotations, top-down splay included
+    std::size_t splays            = 0;
+    std::size_t splay_path_length = 0;   // total depth of the splayed nodes
+    std::size_t allocations       = 0;   // nodes allocated
+    std::size_t deallocations     = 0;   // nodes freed
+    std::size_t rank_steps        = 0;   // parent links followed by get_rank_of
+};
+
+#ifdef SPLAY_TREE_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+enum class stat
+{
+    comparisons,
+    rotations,
+    splays,
+    splay_path_length,
+    allocations,
+    deallocations,
+    rank_steps,
+};
+
+template <bool Enabled> class stats_counters;
+
+// Const operations count too, so the counters are mutable. Every counter is a relaxed atomic
+// bumped with fetch_add, so concurrent readers of a set (frozen views, shards) lose no increments.
+template <> class stats_counters<true>
+{
+    static constexpr std::size_t n_stats = 7;
+
+    mutable std::atomic<std::size_t> m_counters[n_stats] {};
+
+  public:
+    stats_counters () = default;
+
+    // a copy of a set starts counting from scratch
+    stats_counters (const stats_counters &) {}
+    stats_counters &operator= (const stats_counters &) { return *this; }
+
+    void add (stat what, std::size_t n = 1) const
+    {
+        m_counters[static_cast<std::size_t> (what)].fetch_add (n, std::memory_order_relaxed);
+    }
+
+    tree_stats get () const
+    {
+        auto at = [this] (stat what) {
+            return m_counters[static_cast<std::size_t> (what)].load (std::memory_order_relaxed);
+        };
+        return {at (stat::comparisons),       at (stat::rotations),   at (stat::splays),
+                at (stat::splay_path_length), at (stat::allocations), at (stat::deallocations),
+                at (stat::rank_steps)};
+    }
+
+    void reset ()
+    {
+        for ( auto &counter : m_counters )
+            counter.store (0, std::memory_order_relaxed);
+    }
+};
+
+template <> class stats_counters<false>
+{
+  public:
+    void add (stat, std::size_t = 1) const {}
+
+    tree_stats get () const { return {}; }
+
+    void reset () {}
+};
+
+}   // namespace containers
+}   // namespace red
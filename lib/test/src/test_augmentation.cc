@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "splay_dynamic_order_set.hpp"
+
+template struct red::containers::splay_dynamic_order_set<
+    int, std::less<int>, red::containers::node_arena<int>, red::containers::bottom_up_splay,
+    red::containers::augmented_node<int, red::containers::sum_augment<int>>>;
+
+using sum_set = red::containers::augmented_splay_set<int, red::containers::sum_augment<int>>;
+
+namespace
+{
+
+// keys written down in order, combine is not commutative
+struct concat_augment
+{
+    using result_type = std::string;
+
+    static result_type identity () { return {}; }
+    static result_type of (int value) { return std::to_string (value) + ","; }
+    static result_type combine (const result_type &lhs, const result_type &rhs)
+    {
+        return lhs + rhs;
+    }
+};
+
+std::string concat (std::set<int>::iterator first, std::set<int>::iterator last)
+{
+    std::string res;
+    for ( ; first != last; ++first )
+        res += concat_augment::of (*first);
+    return res;
+}
+
+template <typename Splay_t>
+using concat_splay_set = red::containers::augmented_splay_set<int, concat_augment, std::less<int>,
+                                                              red::containers::node_arena<int>,
+                                                              Splay_t>;
+
+using concat_do_set =
+    red::containers::dynamic_order_set<int, std::less<int>, red::containers::node_arena<int>,
+                                       red::containers::augmented_node<int, concat_augment>>;
+
+// random updates against std::set, every aggregate is compared with the brute force one
+template <typename Set_t> void check_against_std_set ()
+{
+    constexpr bool splays = requires (Set_t &tree) { tree.split (0); };
+    Set_t tree;
+    std::set<int> std_set;
+    std::mt19937 gen {17};
+    std::uniform_int_distribution<int> dist {0, 400};
+    for ( int i = 0; i < 3000; ++i )
+    {
+        auto key = dist (gen);
+        if ( std_set.count (key) )
+        {
+            if ( i % 2 )
+                tree.erase (key);
+            else
+                tree.erase (tree.find (key));
+            std_set.erase (key);
+        }
+        else
+        {
+            tree.insert (key);
+            std_set.insert (key);
+        }
+
+        if constexpr ( splays )
+        {
+            if ( i % 100 == 0 )
+            {
+                auto lo = dist (gen), hi = lo + 20;
+                tree.erase (lo, hi);
+                std_set.erase (std_set.lower_bound (lo), std_set.upper_bound (hi));
+            }
+            if ( i % 100 == 50 )
+            {
+                auto upper = tree.split (key);
+                ASSERT_EQ (upper.aggregate (), concat (std_set.lower_bound (key), std_set.end ()));
+                tree.join (upper);
+            }
+        }
+
+        auto lo = dist (gen), hi = dist (gen);
+        ASSERT_EQ (tree.aggregate (lo, hi),
+                   (hi < lo ? "" : concat (std_set.lower_bound (lo), std_set.upper_bound (hi))));
+        ASSERT_EQ (tree.aggregate (), concat (std_set.begin (), std_set.end ()));
+    }
+    Set_t copy {tree};
+    EXPECT_EQ (copy.aggregate (), concat (std_set.begin (), std_set.end ()));
+}
+
+}   // namespace
+
+TEST (test_augmentation, matches_std_set)
+{
+    check_against_std_set<concat_do_set> ();
+    check_against_std_set<concat_splay_set<red::containers::bottom_up_splay>> ();
+    check_against_std_set<concat_splay_set<red::containers::top_down_splay>> ();
+    check_against_std_set<concat_splay_set<red::containers::semi_splay>> ();
+    check_against_std_set<concat_splay_set<red::containers::depth_threshold_splay>> ();
+}
+
+TEST (test_augmentation, sum_min_max)
+{
+    std::vector<int> keys (100);
+    std::iota (keys.begin (), keys.end (), -50);
+    sum_set sums (keys.begin (), keys.end ());
+    red::containers::augmented_splay_set<int, red::containers::min_augment<int>> mins (
+        keys.begin (), keys.end ());
+    red::containers::augmented_splay_set<int, red::containers::max_augment<int>> maxs (
+        keys.begin (), keys.end ());
+
+    EXPECT_EQ (sums.aggregate (), -50);
+    EXPECT_EQ (sums.aggregate (1, 10), 55);
+    EXPECT_EQ (sums.aggregate (10, 1), 0);
+    EXPECT_EQ (sums.aggregate (100, 200), 0);
+    EXPECT_EQ (mins.aggregate (-5, 5), -5);
+    EXPECT_EQ (maxs.aggregate (-5, 5), 5);
+    EXPECT_EQ (mins.aggregate (100, 200), std::numeric_limits<int>::max ());
+
+    sums.erase (5);
+    mins.erase (-5);
+    EXPECT_EQ (sums.aggregate (1, 10), 50);
+    EXPECT_EQ (mins.aggregate (-5, 5), -4);
+    EXPECT_EQ (sums.frozen_view ().aggregate (1, 10), 50);
+}
+
+TEST (test_augmentation, find_by_prefix)
+{
+    // (key, weight) pairs ordered by key, the sums are taken over the weights
+    using item   = std::pair<int, int>;
+    using weight = decltype ([] (const item &it) { return it.second; });
+    red::containers::augmented_splay_set<item, red::containers::sum_augment<item, weight>> tree;
+    std::vector<item> items;
+    std::mt19937 gen {3};
+    for ( int key = 0; key < 500; ++key )
+    {
+        items.emplace_back (key, static_cast<int> (gen () % 10));
+        tree.insert (items.back ());
+    }
+
+    int total = tree.aggregate ();
+    for ( int x = -1; x <= total; x += 7 )
+    {
+        auto it = tree.find_by_prefix ([x] (int prefix) { return prefix > x; });
+        int prefix = 0;
+        auto expected = std::find_if (items.begin (), items.end (), [&] (const item &it) {
+            prefix += it.second;
+            return prefix > x;
+        });
+        if ( expected == items.end () )
+        {
+            EXPECT_EQ (it, tree.end ());
+        }
+        else
+        {
+            ASSERT_NE (it, tree.end ());
+            EXPECT_EQ (*it, *expected);
+        }
+    }
+    EXPECT_EQ (tree.find_by_prefix ([total] (int prefix) { return prefix > total; }), tree.end ());
+    EXPECT_EQ (*tree.frozen_view ().find_by_prefix ([] (int prefix) { return prefix >= 0; }),
+               items.front ());
+}
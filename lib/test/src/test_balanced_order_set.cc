@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "balanced_order_set.hpp"
+
+template struct red::containers::balanced_order_set<int, std::less<int>,
+                                                    red::containers::node_arena<int>,
+                                                    red::containers::treap_node<int>>;
+template struct red::containers::balanced_order_set<int, std::less<int>,
+                                                    red::containers::node_arena<int>,
+                                                    red::containers::avl_node<int>>;
+template struct red::containers::balanced_order_set<int>;
+
+using treap_set = red::containers::treap_order_set<int>;
+using avl_set   = red::containers::avl_order_set<int>;
+using rb_set    = red::containers::rb_order_set<int>;
+
+namespace
+{
+
+using base_node_ptr = red::containers::dl_binary_tree_node_base *;
+
+template <typename Node_t>
+using engine_set = red::containers::balanced_order_set<int, std::less<int>,
+                                                       red::containers::node_arena<int>, Node_t>;
+
+// gives the tests access to the tree itself
+template <typename Set_t> struct inspected : public Set_t
+{
+    using Set_t::Set_t;
+
+    base_node_ptr root_node () const { return Set_t::root (); }
+};
+
+// Checks the links and subtree sizes of the subtree, returns its size.
+std::size_t check_sizes (base_node_ptr node)
+{
+    if ( !node )
+        return 0;
+    for ( auto child : {node->m_left, node->m_right} )
+        if ( child )
+        {
+            EXPECT_EQ (child->m_parent, node);
+        }
+    auto size = check_sizes (node->m_left) + check_sizes (node->m_right) + 1;
+    EXPECT_EQ (red::containers::dynamic_order_set_node<int>::size (node), size);
+    return size;
+}
+
+void check_balance (base_node_ptr root, red::containers::treap_node<int> *)
+{
+    using node = red::containers::treap_node<int>;
+    std::vector<base_node_ptr> stack {root};
+    while ( !stack.empty () )
+    {
+        auto curr = stack.back ();
+        stack.pop_back ();
+        for ( auto child : {curr->m_left, curr->m_right} )
+            if ( child )
+            {
+                EXPECT_LE (node::priority (child), node::priority (curr));
+                stack.push_back (child);
+            }
+    }
+}
+
+int avl_height (base_node_ptr node)
+{
+    using avl = red::containers::avl_node<int>;
+    if ( !node )
+        return 0;
+    auto left  = avl_height (node->m_left);
+    auto right = avl_height (node->m_right);
+    EXPECT_LE (std::abs (left - right), 1);
+    EXPECT_EQ (avl::height (node), std::max (left, right) + 1);
+    return std::max (left, right) + 1;
+}
+
+void check_balance (base_node_ptr root, red::containers::avl_node<int> *) { avl_height (root); }
+
+// returns the number of black nodes on every path down to a leaf
+int black_height (base_node_ptr node)
+{
+    using rb = red::containers::rb_node<int>;
+    if ( !node )
+        return 0;
+    if ( rb::is_red (node) )
+    {
+        EXPECT_FALSE (rb::is_red (node->m_left));
+        EXPECT_FALSE (rb::is_red (node->m_right));
+    }
+    auto left = black_height (node->m_left);
+    EXPECT_EQ (left, black_height (node->m_right));
+    return left + !rb::is_red (node);
+}
+
+void check_balance (base_node_ptr root, red::containers::rb_node<int> *)
+{
+    EXPECT_FALSE (red::containers::rb_node<int>::is_red (root));
+    black_height (root);
+}
+
+template <typename Node_t> void check_tree (const inspected<engine_set<Node_t>> &tree)
+{
+    auto root = tree.root_node ();
+    EXPECT_EQ (check_sizes (root), tree.size ());
+    if ( root )
+        check_balance (root, static_cast<Node_t *> (nullptr));
+}
+
+// random inserts and erases by key and by iterator against std::set, the invariants of the
+// engine are checked after every batch
+template <typename Node_t> void check_against_std_set ()
+{
+    inspected<engine_set<Node_t>> tree;
+    std::set<int> std_set;
+    std::mt19937 gen (42);
+    std::uniform_int_distribution<int> key_dist (0, 2000);
+    for ( int batch = 0; batch < 50; ++batch )
+    {
+        for ( int i = 0; i < 100; ++i )
+        {
+            auto key = key_dist (gen);
+            if ( gen () % 3 )
+            {
+                if ( std_set.insert (key).second )
+                    tree.insert (key);
+                else
+                    EXPECT_THROW (tree.insert (key), std::out_of_range);
+            }
+            else if ( std_set.erase (key) )
+            {
+                if ( key % 2 )
+                    tree.erase (key);
+                else
+                    tree.erase (tree.find (key));
+            }
+        }
+        check_tree (tree);
+        ASSERT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    }
+    for ( std::size_t rank = 1; rank <= std_set.size (); rank += 13 )
+    {
+        auto it = std::next (std_set.begin (), rank - 1);
+        EXPECT_EQ (*tree.os_select (rank), *it);
+        EXPECT_EQ (tree.get_rank_of (tree.find (*it)), rank);
+    }
+    for ( int lo = 0; lo < 2000; lo += 97 )
+        EXPECT_EQ (tree.count_in_range (lo, lo + 300),
+                   std::distance (std_set.lower_bound (lo), std_set.upper_bound (lo + 300)));
+
+    while ( !std_set.empty () )
+    {
+        tree.erase (*std_set.begin ());
+        std_set.erase (std_set.begin ());
+    }
+    check_tree (tree);
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.begin (), tree.end ());
+}
+
+template <typename Node_t> void check_build ()
+{
+    using set_t = inspected<engine_set<Node_t>>;
+    for ( int n = 0; n < 70; ++n )
+    {
+        std::vector<int> keys (n);
+        std::iota (keys.begin (), keys.end (), 0);
+        set_t tree (keys.begin (), keys.end ());
+        check_tree (tree);
+
+        // updates keep working on a built tree and on its copy
+        tree.insert (n);
+        tree.erase (n / 2);
+        check_tree (tree);
+        set_t copy {tree};
+        copy.insert (-1);
+        check_tree (copy);
+        EXPECT_EQ (copy.size (), tree.size () + 1);
+    }
+}
+
+}   // namespace
+
+TEST (test_balanced_order_set, ctor)
+{
+    treap_set {};
+    avl_set {};
+    rb_set {};
+}
+
+TEST (test_balanced_order_set, treap_matches_std_set)
+{
+    check_against_std_set<red::containers::treap_node<int>> ();
+}
+
+TEST (test_balanced_order_set, avl_matches_std_set)
+{
+    check_against_std_set<red::containers::avl_node<int>> ();
+}
+
+TEST (test_balanced_order_set, rb_matches_std_set)
+{
+    check_against_std_set<red::containers::rb_node<int>> ();
+}
+
+TEST (test_balanced_order_set, build)
+{
+    check_build<red::containers::treap_node<int>> ();
+    check_build<red::containers::avl_node<int>> ();
+    check_build<red::containers::rb_node<int>> ();
+}
+
+TEST (test_balanced_order_set, sorted_inserts_stay_shallow)
+{
+    inspected<avl_set> avl;
+    inspected<rb_set> rb;
+    for ( int i = 0; i < 4096; ++i )
+    {
+        avl.insert (i);
+        rb.insert (i);
+    }
+    // 1.44 log2 (n) and 2 log2 (n) bounds
+    EXPECT_LE (avl_height (avl.root_node ()), 18);
+    EXPECT_LE (black_height (rb.root_node ()), 13);
+}
+
+TEST (test_balanced_order_set, erase_keeps_iterators)
+{
+    std::vector<int> keys (100);
+    std::iota (keys.begin (), keys.end (), 0);
+    rb_set tree (keys.begin (), keys.end ());
+    std::vector<rb_set::iterator> iterators;
+    for ( auto key : keys )
+        iterators.push_back (tree.find (key));
+
+    // erasing from the middle first hits nodes with two children
+    for ( std::size_t i = 0; i < keys.size (); ++i )
+    {
+        auto idx = (i * 37) % keys.size ();
+        EXPECT_EQ (*iterators[idx], keys[idx]);
+        tree.erase (iterators[idx]);
+    }
+    EXPECT_TRUE (tree.empty ());
+}
@@ -100,6 +100,32 @@ TEST (test_base_set, move_ctor)
     }
 }
 
+TEST (test_base_set, moved_from)
+{
+    base_set tree {1, 2, 3};
+    base_set tree2 = std::move (tree);
+    tree.clear ();
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.find (2), tree.end ());
+    tree.insert (5);
+    tree.insert (4);
+    EXPECT_EQ (*tree.find (5), 5);
+    EXPECT_EQ (tree.size (), 2);
+
+    base_set tree3;
+    tree3 = std::move (tree2);
+    EXPECT_EQ (tree2.find (1), tree2.end ());
+    tree2.insert (7);
+    EXPECT_EQ (tree2.size (), 1);
+    EXPECT_EQ (tree3.size (), 3);
+    EXPECT_EQ (*tree3.begin (), 1);
+    EXPECT_EQ (*std::prev (tree3.end ()), 3);
+    tree3 = std::move (tree);
+    EXPECT_EQ (*tree3.begin (), 4);
+    EXPECT_EQ (tree.size (), 3);
+    EXPECT_EQ (*tree.find (2), 2);
+}
+
 TEST (test_base_set, erase_leftmost)
 {
     base_set tree;
@@ -366,4 +392,41 @@ TEST (test_base_set, copy_assignment)
 
     tree2 = tree1;
     EXPECT_EQ (tree1, tree2);
+}
+
+TEST (test_base_set, std_allocator)
+{
+    red::containers::base_set<int, std::less<int>, std::allocator<int>> tree;
+    for ( int i = 1; i <= 10; i++ )
+        tree.insert (i);
+    tree.erase (5);
+
+    auto copy = tree;
+    tree.clear ();
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (copy.size (), 9);
+    EXPECT_EQ (*copy.begin (), 1);
+    EXPECT_EQ (*copy.rbegin (), 10);
+}
+
+TEST (test_base_set, reserve)
+{
+    base_set tree;
+    tree.reserve (1000);
+    for ( int i = 0; i < 1000; i++ )
+        tree.insert (i);
+    EXPECT_EQ (tree.size (), 1000);
+    EXPECT_EQ (*tree.rbegin (), 999);
+}
+
+TEST (test_base_set, clear_and_reuse)
+{
+    base_set tree;
+    for ( int i = 0; i < 100; i++ )
+        tree.insert (i);
+    tree.clear ();
+    for ( int i = 100; i > 0; i-- )
+        tree.insert (i);
+    EXPECT_EQ (tree.size (), 100);
+    EXPECT_EQ (*tree.begin (), 1);
 }
\ No newline at end of file
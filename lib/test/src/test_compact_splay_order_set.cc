@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <numeric>
+#include <set>
+#include <vector>
+
+#include "compact_splay_order_set.hpp"
+
+template struct red::containers::compact_splay_order_set<int>;
+template struct red::containers::compact_splay_order_set<int, std::less<int>, false>;
+using compact_set = typename red::containers::compact_splay_order_set<int>;
+
+TEST (test_compact_set, ctor) { compact_set {}; }
+
+TEST (test_compact_set, double_insert)
+{
+    compact_set tree;
+    for ( int i = 0; i < 10; i++ )
+        tree.insert (i);
+
+    auto old_size = tree.size ();
+
+    for ( int i = 0; i < 10; i++ )
+    {
+        EXPECT_THROW (tree.insert (i), std::out_of_range);
+        EXPECT_EQ (tree.size (), old_size);
+    }
+    EXPECT_EQ (*tree.os_select (10), 9);
+}
+
+TEST (test_compact_set, erase_unrepresented)
+{
+    compact_set tree;
+    tree.insert (1);
+    EXPECT_THROW (tree.erase (2), std::out_of_range);
+    EXPECT_EQ (tree.size (), 1);
+}
+
+TEST (test_compact_set, select_and_rank)
+{
+    compact_set tree;
+    for ( int i = 1; i <= 10; i++ )
+        tree.insert (i);
+
+    tree.erase (1);
+    tree.erase (7);
+    tree.erase (4);
+
+    EXPECT_EQ (*tree.os_select (1), 2);
+    EXPECT_EQ (*tree.os_select (3), 5);
+    EXPECT_EQ (tree.os_select (8), tree.end ());
+    EXPECT_EQ (tree.get_rank_of (tree.find (8)), 5);
+    EXPECT_EQ (tree.get_number_less_then (11), 7);
+    EXPECT_EQ (tree.get_number_less_then (4), 2);
+    EXPECT_EQ (tree.get_number_less_then (-4), 0);
+}
+
+TEST (test_compact_set, bounds)
+{
+    compact_set tree;
+    for ( int i = 1; i <= 10; i++ )
+        tree.insert (i);
+
+    tree.erase (1);
+    tree.erase (7);
+    tree.erase (4);
+
+    EXPECT_EQ (tree.lower_bound (11), tree.end ());
+    EXPECT_EQ (*tree.lower_bound (4), 5);
+    EXPECT_EQ (*tree.upper_bound (5), 6);
+    EXPECT_EQ (*tree.upper_bound (-1), 2);
+    EXPECT_EQ (*(--tree.end ()), 10);
+}
+
+TEST (test_compact_set, split_layouts_match_std_set)
+{
+    std::mt19937 gen {42};
+    std::uniform_int_distribution<int> dist {0, 2000};
+    compact_set split;
+    red::containers::compact_splay_order_set<int, std::less<int>, false> joint;
+    std::set<int> std_set;
+
+    for ( int i = 0; i < 20000; i++ )
+    {
+        auto key = dist (gen);
+        if ( std_set.count (key) )
+        {
+            split.erase (key);
+            joint.erase (key);
+            std_set.erase (key);
+        }
+        else
+        {
+            split.insert (key);
+            joint.insert (key);
+            std_set.insert (key);
+        }
+    }
+
+    EXPECT_EQ (split.size (), std_set.size ());
+    EXPECT_TRUE (std::equal (split.begin (), split.end (), std_set.begin (), std_set.end ()));
+    EXPECT_TRUE (std::equal (joint.begin (), joint.end (), std_set.begin (), std_set.end ()));
+    EXPECT_EQ (*split.os_select (std_set.size () / 2),
+               *std::next (std_set.begin (), std_set.size () / 2 - 1));
+}
+
+TEST (test_compact_set, range_ctor)
+{
+    compact_set tree {8, 1, 6, 1, 3, 8};
+    EXPECT_EQ (tree.size (), 4);
+    EXPECT_EQ (*tree.os_select (1), 1);
+    EXPECT_EQ (*tree.os_select (4), 8);
+    EXPECT_EQ (tree.get_rank_of (tree.find (6)), 3);
+
+    tree.insert (2);
+    tree.erase (8);
+    EXPECT_EQ (*tree.os_select (2), 2);
+    EXPECT_EQ (tree.size (), 4);
+
+    std::vector<int> keys (777);
+    std::iota (keys.begin (), keys.end (), 1);
+    tree.assign (keys.begin (), keys.end ());
+    EXPECT_EQ (tree.size (), 777);
+    for ( std::size_t rank = 1; rank <= 777; rank += 19 )
+        EXPECT_EQ (*tree.os_select (rank), rank);
+    EXPECT_EQ (tree.lower_bound (778), tree.end ());
+}
+
+TEST (test_compact_set, count_in_range)
+{
+    compact_set tree {10, 20, 30, 40, 50};
+
+    EXPECT_EQ (tree.count_in_range (29, 35), 1);
+    EXPECT_EQ (tree.count_in_range (34, 37), 0);
+    EXPECT_EQ (tree.count_in_range (10, 50), 5);
+    EXPECT_EQ (tree.count_in_range (32, 411), 2);
+    EXPECT_EQ (tree.count_in_range (-5, 5), 0);
+    EXPECT_EQ (tree.count_in_range (40, 20), 0);
+    EXPECT_EQ (tree.count_less (31), 3);
+    EXPECT_EQ (tree.count_less (100), 5);
+    EXPECT_EQ (tree.count_greater (20), 3);
+    EXPECT_EQ (tree.count_greater (50), 0);
+    EXPECT_EQ (compact_set {}.count_in_range (0, 1), 0);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
 #include <set>
+#include <vector>
 
 #include "dynamic_order_set.hpp"
 
@@ -79,6 +82,8 @@ TEST (test_dynamic_order_set, copy_ctor)
     EXPECT_EQ (tree1, tree2);
     tree1.clear ();
     EXPECT_TRUE (std::equal (tree2.begin (), tree2.end (), std_set.begin ()));
+    EXPECT_EQ (*tree2.os_select (3), 5);
+    EXPECT_EQ (tree2.get_rank_of (tree2.os_select (7)), 7);
 }
 
 TEST (test_dynamic_order_set, copy_assignment)
@@ -110,4 +115,100 @@ TEST (test_dynamic_order_set, dump)
     for ( int i = 1; i <= 10; i++ )
         tree.insert (i);
     tree.dump (os);
-}
\ No newline at end of file
+}
+
+TEST (test_dynamic_order_set, node_layout)
+{
+    using node = red::containers::dynamic_order_set_node<int>;
+    static_assert (!std::is_polymorphic_v<node>);
+    static_assert (std::is_trivially_destructible_v<node>);
+    EXPECT_LE (sizeof (node), 3 * sizeof (void *) + sizeof (std::size_t) + sizeof (int) + 4);
+}
+
+TEST (test_dynamic_order_set, range_ctor)
+{
+    std::vector<int> keys {5, 3, 9, 1, 3, 7, 5, 2};
+    do_set tree (keys.begin (), keys.end ());
+    std::set<int> std_set (keys.begin (), keys.end ());
+
+    EXPECT_EQ (tree.size (), std_set.size ());
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    EXPECT_EQ (*tree.begin (), 1);
+    EXPECT_EQ (*tree.rbegin (), 9);
+    EXPECT_EQ (*tree.os_select (4), 5);
+    EXPECT_EQ (tree.get_rank_of (tree.find (9)), 6);
+
+    tree.insert (4);
+    EXPECT_EQ (*tree.os_select (4), 4);
+    tree.erase (1);
+    EXPECT_EQ (*tree.begin (), 2);
+}
+
+TEST (test_dynamic_order_set, assign_sorted)
+{
+    do_set tree {10, 20};
+    std::vector<int> keys (1000);
+    std::iota (keys.begin (), keys.end (), 0);
+    tree.assign (keys.begin (), keys.end ());
+
+    EXPECT_EQ (tree.size (), 1000);
+    for ( std::size_t rank = 1; rank <= 1000; rank += 37 )
+        EXPECT_EQ (*tree.os_select (rank), rank - 1);
+    EXPECT_EQ (*tree.rbegin (), 999);
+
+    tree.assign ({});
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.begin (), tree.end ());
+}
+
+TEST (test_dynamic_order_set, count_in_range)
+{
+    do_set tree {10, 20, 30, 40, 50};
+
+    EXPECT_EQ (tree.count_in_range (29, 35), 1);
+    EXPECT_EQ (tree.count_in_range (34, 37), 0);
+    EXPECT_EQ (tree.count_in_range (10, 50), 5);
+    EXPECT_EQ (tree.count_in_range (32, 411), 2);
+    EXPECT_EQ (tree.count_in_range (-5, 5), 0);
+    EXPECT_EQ (tree.count_in_range (40, 20), 0);
+    EXPECT_EQ (tree.count_less (10), 0);
+    EXPECT_EQ (tree.count_less (31), 3);
+    EXPECT_EQ (tree.count_less (100), 5);
+    EXPECT_EQ (tree.count_greater (50), 0);
+    EXPECT_EQ (tree.count_greater (20), 3);
+    EXPECT_EQ (tree.count_greater (-1), 5);
+    EXPECT_EQ (do_set {}.count_in_range (0, 1), 0);
+}
+
+TEST (test_dynamic_order_set, count_in_ranges)
+{
+    std::vector<int> keys (5000);
+    for ( std::size_t i = 0; i < keys.size (); i++ )
+        keys[i] = static_cast<int> (i * 7919 % 10007);
+    do_set tree (keys.begin (), keys.end ());
+    std::set<int> std_set (keys.begin (), keys.end ());
+
+    std::vector<int> sorted (std_set.begin (), std_set.end ());
+
+    // large enough to be split between the threads
+    std::vector<std::pair<int, int>> queries;
+    for ( int i = 0; i < 70000; i++ )
+        queries.emplace_back (i * 31 % 10100 - 50, i * 17 % 10100 - 50);
+
+    auto single = tree.count_in_ranges (queries, 1);
+    auto multi  = tree.count_in_ranges (queries, 4);
+    ASSERT_EQ (single.size (), queries.size ());
+    EXPECT_EQ (single, multi);
+    for ( std::size_t i = 0; i < queries.size (); i++ )
+    {
+        auto [lo, hi] = queries[i];
+        auto expected = (lo > hi ? 0
+                                 : std::upper_bound (sorted.begin (), sorted.end (), hi) -
+                                       std::lower_bound (sorted.begin (), sorted.end (), lo));
+        ASSERT_EQ (single[i], expected);
+    }
+    std::vector<std::pair<int, int>> small (queries.begin (), queries.begin () + 100);
+    EXPECT_EQ (tree.count_in_ranges (small, 4),
+               std::vector<std::size_t> (single.begin (), single.begin () + 100));
+    EXPECT_TRUE (tree.count_in_ranges ({}).empty ());
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "fast_io.hpp"
+#include "workload.hpp"
+
+namespace
+{
+
+// input_buffer over a pipe holding text
+struct piped_input
+{
+    int m_fds[2] {-1, -1};
+
+    explicit piped_input (std::string_view text)
+    {
+        if ( pipe (m_fds) )
+            throw std::runtime_error ("pipe failed");
+        auto written = write (m_fds[1], text.data (), text.size ());
+        close (m_fds[1]);
+        if ( written != static_cast<ssize_t> (text.size ()) )
+            throw std::runtime_error ("write failed");
+    }
+
+    ~piped_input () { close (m_fds[0]); }
+
+    int fd () const { return m_fds[0]; }
+};
+
+// encoded workload with its header patched by set_header
+template <typename F> std::vector<char> patched_workload (bool compress, F set_header)
+{
+    std::vector<std::int32_t> elements {3, -1, 7};
+    std::vector<red::io::range_query> queries {{-1, 3}};
+    auto data = red::io::encode_workload (elements, queries, compress);
+    red::io::workload_header header;
+    std::memcpy (&header, data.data (), sizeof (header));
+    set_header (header);
+    std::memcpy (data.data (), &header, sizeof (header));
+    return data;
+}
+
+std::size_t load_elements (const std::vector<char> &data)
+{
+    piped_input binary {std::string_view {data.data (), data.size ()}};
+    red::io::input_buffer input {binary.fd ()};
+    return red::io::workload {input}.elements ().size ();
+}
+
+}   // namespace
+
+TEST (test_fast_io, read_integers)
+{
+    piped_input text {"  12 -7\n2147483647 -2147483648 18446744073709551615"};
+    red::io::input_buffer input {text.fd ()};
+    EXPECT_EQ (input.read<int> (), 12);
+    EXPECT_EQ (input.read<int> (), -7);
+    EXPECT_EQ (input.read<int> (), 2147483647);
+    EXPECT_EQ (input.read<int> (), -2147483648);
+    EXPECT_EQ (input.read<std::uint64_t> (), 18446744073709551615u);
+    EXPECT_THROW (input.read<int> (), std::runtime_error);
+}
+
+TEST (test_fast_io, read_out_of_range)
+{
+    piped_input text {"99999999999 -2147483649 -1 300 x"};
+    red::io::input_buffer input {text.fd ()};
+    EXPECT_THROW (input.read<int> (), std::runtime_error);
+    EXPECT_EQ (input.read_word (), "99999999999");
+    EXPECT_THROW (input.read<int> (), std::runtime_error);
+    EXPECT_EQ (input.read_word (), "-2147483649");
+    EXPECT_THROW (input.read<unsigned> (), std::runtime_error);
+    EXPECT_EQ (input.read_word (), "-1");
+    EXPECT_THROW (input.read<std::uint8_t> (), std::runtime_error);
+    EXPECT_EQ (input.read_word (), "300");
+    EXPECT_THROW (input.read<int> (), std::runtime_error);
+}
+
+TEST (test_fast_io, binary_workload)
+{
+    auto keep = [] (red::io::workload_header &) {};
+    EXPECT_EQ (load_elements (patched_workload (false, keep)), 3);
+    EXPECT_EQ (load_elements (patched_workload (true, keep)), 3);
+
+    auto truncated = patched_workload (false, keep);
+    truncated.resize (truncated.size () - 1);
+    EXPECT_THROW (load_elements (truncated), std::runtime_error);
+}
+
+TEST (test_fast_io, binary_workload_oversized_header)
+{
+    // 2^62 + 3 int32 take 4 * 3 bytes once the multiplication wraps around
+    auto wrapped = patched_workload (false, [] (red::io::workload_header &header) {
+        header.n_elements = (std::uint64_t {1} << 62) + 3;
+    });
+    EXPECT_THROW (load_elements (wrapped), std::runtime_error);
+
+    auto huge = patched_workload (true, [] (red::io::workload_header &header) {
+        header.n_elements = std::uint64_t {1} << 40;
+    });
+    EXPECT_THROW (load_elements (huge), std::runtime_error);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <optional>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "sharded_order_set.hpp"
+
+template class red::containers::sharded_order_set<int>;
+using sharded_set = typename red::containers::sharded_order_set<int>;
+
+TEST (test_sharded_set, ctor)
+{
+    sharded_set set {4};
+    EXPECT_EQ (set.n_shards (), 4);
+    EXPECT_TRUE (set.empty ());
+    EXPECT_EQ (set.os_select (1), std::nullopt);
+    EXPECT_EQ (set.count_in_range (0, 10), 0);
+}
+
+TEST (test_sharded_set, double_insert)
+{
+    sharded_set set {2};
+    set.insert (1);
+    EXPECT_THROW (set.insert (1), std::out_of_range);
+    EXPECT_THROW (set.erase (2), std::out_of_range);
+    EXPECT_EQ (set.size (), 1);
+}
+
+TEST (test_sharded_set, rebalances_two_shards)
+{
+    sharded_set set {2};
+    constexpr int n_keys = 5 * sharded_set::min_rebalance_size;
+    for ( int i = 0; i < n_keys; i++ )
+        set.insert (i);
+
+    // all the keys start in the first shard, so it has to be split at some point
+    EXPECT_GT (set.shard_size (1), 0);
+    EXPECT_LT (set.shard_size (0), n_keys);
+    EXPECT_EQ (set.shard_size (0) + set.shard_size (1), n_keys);
+    EXPECT_EQ (set.get_rank_of (n_keys - 1), n_keys);
+    EXPECT_EQ (set.get_rank_of (n_keys), std::nullopt);
+}
+
+TEST (test_sharded_set, matches_std_set)
+{
+    std::mt19937 gen {3};
+    std::uniform_int_distribution<int> dist {0, 100000};
+    sharded_set set {5};
+    std::set<int> std_set;
+
+    for ( int i = 0; i < 30000; i++ )
+    {
+        auto key = dist (gen);
+        if ( std_set.insert (key).second )
+            set.insert (key);
+    }
+    for ( int i = 0; i < 5000; i++ )
+    {
+        auto key = dist (gen);
+        if ( std_set.erase (key) )
+            set.erase (key);
+    }
+    set.rebalance ();
+    EXPECT_EQ (set.size (), std_set.size ());
+
+    for ( int i = 0; i < 2000; i++ )
+    {
+        auto lo = dist (gen), hi = dist (gen);
+        auto expected =
+            (lo > hi ? 0 : std::distance (std_set.lower_bound (lo), std_set.upper_bound (hi)));
+        ASSERT_EQ (set.count_in_range (lo, hi), expected);
+        ASSERT_EQ (set.count_less (lo), std::distance (std_set.begin (), std_set.lower_bound (lo)));
+        ASSERT_EQ (set.contains (lo), std_set.count (lo) == 1);
+    }
+
+    std::size_t rank = 1;
+    for ( auto key : std_set )
+    {
+        if ( rank % 97 == 1 )
+        {
+            ASSERT_EQ (set.os_select (rank), key);
+            ASSERT_EQ (set.get_rank_of (key), rank);
+        }
+        rank++;
+    }
+    EXPECT_EQ (set.os_select (rank), std::nullopt);
+}
+
+TEST (test_sharded_set, concurrent_insert)
+{
+    constexpr int n_threads = 8, n_keys = 20000;
+    sharded_set set {4};
+    std::vector<std::thread> writers;
+    for ( int t = 0; t < n_threads; t++ )
+        writers.emplace_back ([&set, t] {
+            for ( int i = t; i < n_keys; i += n_threads )
+            {
+                set.insert (i);
+                if ( i % 7 == 0 )
+                    set.count_in_range (i / 2, i);
+            }
+        });
+    for ( auto &writer : writers )
+        writer.join ();
+
+    EXPECT_EQ (set.size (), n_keys);
+    EXPECT_EQ (set.count_in_range (0, n_keys), n_keys);
+    for ( int i = 0; i < n_keys; i += 101 )
+        ASSERT_EQ (set.os_select (i + 1), i);
+}
+
+TEST (test_sharded_set, shard_size_during_rebalance)
+{
+    constexpr int n_threads = 4, n_keys = 8 * sharded_set::min_rebalance_size;
+    sharded_set set {4};
+    std::atomic<bool> done {false};
+    std::thread reader {[&set, &done] {
+        while ( !done )
+        {
+            std::size_t total = 0;
+            for ( std::size_t i = 0; i < set.n_shards (); i++ )
+                total += set.shard_size (i);
+            ASSERT_LE (total, static_cast<std::size_t> (n_keys));
+        }
+    }};
+
+    std::vector<std::thread> writers;
+    for ( int t = 0; t < n_threads; t++ )
+        writers.emplace_back ([&set, t] {
+            for ( int i = t; i < n_keys; i += n_threads )
+                set.insert (i);
+        });
+    for ( auto &writer : writers )
+        writer.join ();
+    done = true;
+    reader.join ();
+
+    // the keys go in ascending order, so they can not stay in the first shard
+    EXPECT_LT (set.shard_size (0), n_keys);
+    EXPECT_EQ (set.size (), n_keys);
+}
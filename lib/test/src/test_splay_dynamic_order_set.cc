@@ -1,11 +1,26 @@
 #include <gtest/gtest.h>
+#include <numeric>
+#include <random>
 #include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "splay_dynamic_order_set.hpp"
 
 template struct red::containers::splay_dynamic_order_set<int>;
 using splay_set = typename red::containers::splay_dynamic_order_set<int>;
 
+template struct red::containers::splay_dynamic_order_set<int, std::less<int>,
+                                                         red::containers::node_arena<int>,
+                                                         red::containers::top_down_splay>;
+using top_down_set =
+    typename red::containers::splay_dynamic_order_set<int, std::less<int>,
+                                                      red::containers::node_arena<int>,
+                                                      red::containers::top_down_splay>;
+
 TEST (test_splay_set, ctor) { splay_set {}; }
 
 TEST (test_splay_set, double_insert)
@@ -100,6 +115,32 @@ TEST (test_splay_set, move_ctor)
     }
 }
 
+TEST (test_splay_set, moved_from)
+{
+    splay_set tree {1, 2, 3};
+    splay_set tree2 = std::move (tree);
+    tree.clear ();
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.find (2), tree.end ());
+    tree.insert (5);
+    tree.insert (4);
+    EXPECT_EQ (*tree.find (5), 5);
+    EXPECT_EQ (tree.size (), 2);
+
+    splay_set tree3;
+    tree3 = std::move (tree2);
+    EXPECT_EQ (tree2.find (1), tree2.end ());
+    tree2.insert (7);
+    EXPECT_EQ (tree2.size (), 1);
+    EXPECT_EQ (tree3.size (), 3);
+    EXPECT_EQ (*tree3.begin (), 1);
+    EXPECT_EQ (*std::prev (tree3.end ()), 3);
+    tree3 = std::move (tree);
+    EXPECT_EQ (*tree3.begin (), 4);
+    EXPECT_EQ (tree.size (), 3);
+    EXPECT_EQ (*tree.find (2), 2);
+}
+
 TEST (test_splay_set, erase_leftmost)
 {
     splay_set tree;
@@ -366,4 +407,757 @@ TEST (test_splay_set, dump)
     for ( int i = 1; i <= 10; i++ )
         tree.insert (i);
     tree.dump (os);
-}
\ No newline at end of file
+}
+
+TEST (test_splay_set, erase_many)
+{
+    splay_set tree;
+    for ( int i = 0; i < 10000; i++ )
+        tree.insert ((i * 7919) % 10000);
+
+    for ( int i = 0; i < 10000; i += 2 )
+        tree.erase (i);
+    EXPECT_EQ (tree.size (), 5000);
+    EXPECT_EQ (*tree.begin (), 1);
+
+    for ( int i = 1; i < 10000; i += 2 )
+        tree.erase (i);
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.begin (), tree.end ());
+}
+
+
+TEST (test_splay_set, top_down_bounds)
+{
+    top_down_set tree;
+
+    for ( int i = 1; i <= 10; i++ )
+        tree.insert (i);
+
+    tree.erase (1);
+    tree.erase (7);
+    tree.erase (4);
+
+    EXPECT_EQ (tree.lower_bound (11), tree.end ());
+    EXPECT_EQ (*tree.lower_bound (4), 5);
+    EXPECT_EQ (*tree.lower_bound (-1), 2);
+    EXPECT_EQ (*tree.upper_bound (5), 6);
+    EXPECT_EQ (*tree.upper_bound (1), 2);
+    EXPECT_EQ (tree.upper_bound (10), tree.end ());
+    EXPECT_EQ (tree.get_rank_of (tree.lower_bound (6)), 4);
+    EXPECT_EQ (tree.find (7), tree.end ());
+    EXPECT_THROW (tree.insert (5), std::out_of_range);
+    EXPECT_THROW (tree.erase (7), std::out_of_range);
+    EXPECT_EQ (tree.size (), 7);
+}
+
+TEST (test_splay_set, top_down_matches_std_set)
+{
+    std::mt19937 gen {7};
+    std::uniform_int_distribution<int> dist {0, 1000};
+    top_down_set tree;
+    std::set<int> std_set;
+
+    for ( int i = 0; i < 10000; i++ )
+    {
+        auto key = dist (gen);
+        if ( std_set.count (key) )
+        {
+            if ( i % 2 )
+                tree.erase (key);
+            else
+                tree.erase (tree.find (key));
+            std_set.erase (key);
+        }
+        else
+        {
+            tree.insert (key);
+            std_set.insert (key);
+        }
+
+        auto bound = dist (gen);
+        auto lb    = tree.lower_bound (bound);
+        auto std_lb = std_set.lower_bound (bound);
+        ASSERT_EQ (lb == tree.end (), std_lb == std_set.end ());
+        if ( lb != tree.end () )
+        {
+            ASSERT_EQ (*lb, *std_lb);
+            ASSERT_EQ (tree.get_rank_of (lb), std::distance (std_set.begin (), std_lb) + 1);
+        }
+    }
+
+    EXPECT_EQ (tree.size (), std_set.size ());
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    EXPECT_TRUE (std::equal (tree.rbegin (), tree.rend (), std_set.rbegin (), std_set.rend ()));
+    for ( std::size_t rank = 1; rank <= std_set.size (); rank += 17 )
+        EXPECT_EQ (*tree.os_select (rank), *std::next (std_set.begin (), rank - 1));
+}
+TEST (test_splay_set, range_ctor)
+{
+    std::mt19937 gen {11};
+    std::uniform_int_distribution<int> dist {0, 5000};
+    std::vector<int> keys (3000);
+    for ( auto &key : keys )
+        key = dist (gen);
+    std::set<int> std_set (keys.begin (), keys.end ());
+
+    splay_set tree (keys.begin (), keys.end ());
+    top_down_set td_tree (std_set.begin (), std_set.end ());
+    EXPECT_EQ (tree.size (), std_set.size ());
+    EXPECT_EQ (td_tree.size (), std_set.size ());
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    EXPECT_TRUE (
+        std::equal (td_tree.rbegin (), td_tree.rend (), std_set.rbegin (), std_set.rend ()));
+
+    for ( int bound = -1; bound < 5002; bound += 13 )
+    {
+        auto std_lb = std_set.lower_bound (bound);
+        auto lb     = tree.lower_bound (bound);
+        auto td_lb  = td_tree.lower_bound (bound);
+        ASSERT_EQ (lb == tree.end (), std_lb == std_set.end ());
+        ASSERT_EQ (td_lb == td_tree.end (), std_lb == std_set.end ());
+        if ( lb != tree.end () )
+        {
+            ASSERT_EQ (tree.get_rank_of (lb), std::distance (std_set.begin (), std_lb) + 1);
+            ASSERT_EQ (td_tree.get_rank_of (td_lb), std::distance (std_set.begin (), std_lb) + 1);
+        }
+    }
+}
+
+TEST (test_splay_set, count_in_range)
+{
+    std::mt19937 gen {5};
+    std::uniform_int_distribution<int> dist {0, 2000};
+    std::vector<int> keys (1000);
+    for ( auto &key : keys )
+        key = dist (gen);
+    std::set<int> std_set (keys.begin (), keys.end ());
+    splay_set tree (keys.begin (), keys.end ());
+    top_down_set td_tree (keys.begin (), keys.end ());
+
+    EXPECT_EQ (splay_set {}.count_in_range (0, 1), 0);
+    EXPECT_EQ (top_down_set {}.count_less (1), 0);
+    for ( int i = 0; i < 2000; i++ )
+    {
+        auto lo = dist (gen) - 10, hi = dist (gen) + 10;
+        auto expected =
+            (lo > hi ? 0 : std::distance (std_set.lower_bound (lo), std_set.upper_bound (hi)));
+        ASSERT_EQ (tree.count_in_range (lo, hi), expected);
+        ASSERT_EQ (td_tree.count_in_range (lo, hi), expected);
+
+        auto less = std::distance (std_set.begin (), std_set.lower_bound (lo));
+        ASSERT_EQ (tree.count_less (lo), less);
+        ASSERT_EQ (td_tree.count_less (lo), less);
+
+        auto greater = std::distance (std_set.upper_bound (hi), std_set.end ());
+        ASSERT_EQ (tree.count_greater (hi), greater);
+        ASSERT_EQ (td_tree.count_greater (hi), greater);
+    }
+}
+
+TEST (test_splay_set, frozen_view)
+{
+    splay_set tree;
+    for ( int i = 1; i <= 1000; i++ )
+        tree.insert (i * 3 % 1001);
+    tree.find (500);
+
+    auto view = tree.frozen_view ();
+    std::vector<std::thread> readers;
+    std::vector<int> failures (4);
+    for ( int t = 0; t < 4; t++ )
+        readers.emplace_back ([&view, &failures, t] {
+            for ( int key = 1; key <= 1000; key++ )
+            {
+                auto lb   = view.lower_bound (key);
+                auto rank = static_cast<std::size_t> (key);
+                if ( lb == view.end () || *lb != key || view.get_rank_of (lb) != rank ||
+                     *view.os_select (key) != key || *view.upper_bound (key - 1) != key ||
+                     view.count_in_range (key, 1000) != 1001 - rank || !view.contains (key) )
+                    failures[t]++;
+            }
+        });
+    for ( auto &reader : readers )
+        reader.join ();
+    EXPECT_EQ (failures, std::vector<int> (4, 0));
+    EXPECT_EQ (view.size (), 1000);
+    EXPECT_EQ (view.count_less (11), 10);
+    EXPECT_EQ (view.count_greater (990), 10);
+    EXPECT_EQ (view.find (0), view.end ());
+
+    // the view does not restructure: the root found by the last splaying lookup stays in place
+    std::ostringstream before, after;
+    tree.dump (before);
+    view.lower_bound (1);
+    view.os_select (1000);
+    tree.dump (after);
+    EXPECT_EQ (before.str (), after.str ());
+
+    tree.insert (1001);
+    EXPECT_EQ (*tree.frozen_view ().os_select (1001), 1001);
+}
+
+TEST (test_splay_set, stats)
+{
+    splay_set tree;
+    top_down_set td_tree;
+    for ( int i = 0; i < 100; i++ )
+    {
+        tree.insert (i);
+        td_tree.insert (i);
+    }
+    // a sorted insertion sequence makes a path, the lookup of the minimum walks all of it
+    tree.reset_stats ();
+    td_tree.reset_stats ();
+    tree.find (0);
+    td_tree.find (0);
+    tree.get_rank_of (tree.os_select (50));
+
+    auto stats    = tree.stats ();
+    auto td_stats = td_tree.stats ();
+    if constexpr ( red::containers::stats_enabled )
+    {
+        EXPECT_EQ (stats.splays, 1);
+        EXPECT_EQ (stats.splay_path_length, 99);
+        EXPECT_EQ (stats.rotations, 99);
+        EXPECT_GE (stats.comparisons, 99);
+        EXPECT_EQ (stats.allocations, 0);
+        EXPECT_GT (stats.rank_steps, 0);
+        EXPECT_EQ (td_stats.splays, 1);
+        EXPECT_EQ (td_stats.splay_path_length, 99);
+        EXPECT_GE (td_stats.comparisons, 99);
+
+        // a copy counts only its own work
+        splay_set copy {tree};
+        EXPECT_EQ (copy.stats ().allocations, 100);
+        EXPECT_EQ (copy.stats ().comparisons, 0);
+        copy.insert (100);
+        copy.clear ();
+        EXPECT_EQ (copy.stats ().allocations, 101);
+        EXPECT_EQ (copy.stats ().deallocations, 101);
+    }
+    else
+    {
+        EXPECT_EQ (stats.comparisons, 0);
+        EXPECT_EQ (stats.rotations, 0);
+        EXPECT_EQ (td_stats.splays, 0);
+    }
+
+    tree.reset_stats ();
+    EXPECT_EQ (tree.stats ().comparisons, 0);
+    EXPECT_EQ (tree.stats ().splays, 0);
+}
+
+template <typename Splay_t> void check_policy_against_std_set ()
+{
+    using policy_set = red::containers::splay_dynamic_order_set<
+        int, std::less<int>, red::containers::node_arena<int>, Splay_t>;
+    std::mt19937 gen {13};
+    std::uniform_int_distribution<int> dist {0, 1000};
+    policy_set tree;
+    std::set<int> std_set;
+
+    for ( int i = 0; i < 10000; i++ )
+    {
+        auto key = dist (gen);
+        if ( std_set.count (key) )
+        {
+            ASSERT_NE (tree.find (key), tree.end ());
+            tree.erase (key);
+            std_set.erase (key);
+        }
+        else
+        {
+            tree.insert (key);
+            std_set.insert (key);
+        }
+
+        auto lo = dist (gen), hi = dist (gen);
+        if ( hi < lo )
+            std::swap (lo, hi);
+        auto std_lb = std_set.lower_bound (lo);
+        auto lb     = tree.lower_bound (lo);
+        ASSERT_EQ (lb == tree.end (), std_lb == std_set.end ());
+        if ( lb != tree.end () )
+        {
+            ASSERT_EQ (*lb, *std_lb);
+        }
+        auto less = std::distance (std_set.begin (), std_lb);
+        ASSERT_EQ (tree.count_less (lo), less);
+        ASSERT_EQ (tree.count_greater (hi),
+                   std::distance (std_set.upper_bound (hi), std_set.end ()));
+        ASSERT_EQ (tree.count_in_range (lo, hi),
+                   std::distance (std_lb, std_set.upper_bound (hi)));
+    }
+
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    for ( std::size_t rank = 1; rank <= std_set.size (); rank += 17 )
+        EXPECT_EQ (*tree.os_select (rank), *std::next (std_set.begin (), rank - 1));
+}
+
+// concurrent readers of a frozen view add up their counts
+TEST (test_splay_set, concurrent_stats)
+{
+    splay_set tree;
+    for ( int i = 0; i < 1000; i++ )
+        tree.insert (i * 7 % 1000);
+    auto view  = tree.frozen_view ();
+    auto count = [&view] {
+        for ( int key = 0; key < 1000; key++ )
+            view.count_in_range (key, key + 10);
+    };
+
+    tree.reset_stats ();
+    count ();
+    auto single = tree.stats ().comparisons;
+    tree.reset_stats ();
+    std::vector<std::thread> readers;
+    for ( int t = 0; t < 4; t++ )
+        readers.emplace_back (count);
+    for ( auto &reader : readers )
+        reader.join ();
+    EXPECT_EQ (tree.stats ().comparisons, 4 * single);
+}
+
+TEST (test_splay_set, policies_match_std_set)
+{
+    check_policy_against_std_set<red::containers::semi_splay> ();
+    check_policy_against_std_set<red::containers::depth_threshold_splay> ();
+    check_policy_against_std_set<red::containers::randomized_splay> ();
+}
+
+TEST (test_splay_set, policy_parameters)
+{
+    using random_set =
+        red::containers::splay_dynamic_order_set<int, std::less<int>,
+                                                 red::containers::node_arena<int>,
+                                                 red::containers::randomized_splay>;
+    using threshold_set =
+        red::containers::splay_dynamic_order_set<int, std::less<int>,
+                                                 red::containers::node_arena<int>,
+                                                 red::containers::depth_threshold_splay>;
+    std::vector<int> keys (1000);
+    std::iota (keys.begin (), keys.end (), 0);
+
+    // a balanced tree has no node deeper than the threshold, so lookups do not restructure it
+    threshold_set balanced (keys.begin (), keys.end ());
+    std::ostringstream before, after;
+    balanced.dump (before);
+    for ( auto key : keys )
+        balanced.find (key);
+    balanced.dump (after);
+    EXPECT_EQ (before.str (), after.str ());
+
+    // a path left by sorted inserts that never splay is restructured by the first deep lookup
+    threshold_set path;
+    path.splay_policy ().m_factor = 1e9;
+    for ( auto key : keys )
+        path.insert (key);
+    std::ostringstream path_before, path_after;
+    path.dump (path_before);
+    path.splay_policy ().m_factor = 2.0;
+    path.find (999);
+    path.dump (path_after);
+    EXPECT_NE (path_before.str (), path_after.str ());
+    EXPECT_TRUE (std::equal (path.begin (), path.end (), keys.begin (), keys.end ()));
+
+    // the depth of a bound is counted by its descent as well
+    threshold_set bound_path;
+    bound_path.splay_policy ().m_factor = 1e9;
+    for ( auto key : keys )
+        bound_path.insert (key);
+    bound_path.splay_policy ().m_factor = 2.0;
+    EXPECT_EQ (*bound_path.lower_bound (998), 998);
+    std::ostringstream bound_after;
+    bound_path.dump (bound_after);
+    EXPECT_NE (path_before.str (), bound_after.str ());
+    EXPECT_TRUE (std::equal (bound_path.begin (), bound_path.end (), keys.begin (), keys.end ()));
+
+    random_set never (keys.begin (), keys.end ());
+    never.splay_policy ().m_probability = 0.0;
+    std::ostringstream never_before, never_after;
+    never.dump (never_before);
+    for ( auto key : keys )
+        never.find (key);
+    never.dump (never_after);
+    EXPECT_EQ (never_before.str (), never_after.str ());
+}
+
+template <typename Set_t> void check_split_join ()
+{
+    std::vector<int> keys (1000);
+    std::iota (keys.begin (), keys.end (), 0);
+    Set_t tree (keys.begin (), keys.end ());
+    for ( int key : {500, 0, 1000, 250, 999} )
+    {
+        auto upper = tree.split (key);
+        ASSERT_EQ (tree.size (), static_cast<std::size_t> (key));
+        ASSERT_EQ (upper.size (), keys.size () - key);
+        EXPECT_TRUE (std::equal (tree.begin (), tree.end (), keys.begin (), keys.begin () + key));
+        EXPECT_TRUE (std::equal (upper.begin (), upper.end (), keys.begin () + key, keys.end ()));
+        EXPECT_TRUE (std::equal (upper.rbegin (), upper.rend (), keys.rbegin (),
+                                 keys.rbegin () + (keys.size () - key)));
+        if ( !upper.empty () )
+        {
+            EXPECT_EQ (*upper.os_select (1), key);
+            EXPECT_EQ (upper.count_less (key + 10), std::min<std::size_t> (10, upper.size ()));
+        }
+        if ( !tree.empty () )
+        {
+            EXPECT_EQ (*tree.os_select (key), key - 1);
+        }
+
+        tree.join (upper);
+        EXPECT_TRUE (upper.empty ());
+        ASSERT_TRUE (std::equal (tree.begin (), tree.end (), keys.begin (), keys.end ()));
+        EXPECT_EQ (*tree.os_select (777), 776);
+        EXPECT_EQ (tree.get_rank_of (tree.find (300)), 301);
+    }
+}
+
+TEST (test_splay_set, split_join)
+{
+    check_split_join<splay_set> ();
+    check_split_join<top_down_set> ();
+    check_split_join<red::containers::splay_dynamic_order_set<
+        int, std::less<int>, red::containers::node_arena<int>, red::containers::semi_splay>> ();
+}
+
+// the half split off gets the configuration of the policy, but not its random stream
+TEST (test_splay_set, split_forks_random_policy)
+{
+    red::containers::splay_dynamic_order_set<int, std::less<int>, red::containers::node_arena<int>,
+                                             red::containers::randomized_splay>
+        tree {1, 2, 3, 4};
+    tree.splay_policy ().m_probability = 0.25;
+    auto upper = tree.split (3);
+    EXPECT_EQ (upper.splay_policy ().m_probability, 0.25);
+
+    std::vector<bool> lower_coins, upper_coins;
+    for ( int i = 0; i < 64; i++ )
+    {
+        lower_coins.push_back (tree.splay_policy ().should_splay (0, 0));
+        upper_coins.push_back (upper.splay_policy ().should_splay (0, 0));
+    }
+    EXPECT_NE (lower_coins, upper_coins);
+}
+
+TEST (test_splay_set, join_checks_order)
+{
+    splay_set lower {1, 2, 3}, upper {3, 4};
+    EXPECT_THROW (lower.join (upper), std::out_of_range);
+    EXPECT_EQ (lower.size (), 3);
+    EXPECT_EQ (upper.size (), 2);
+
+    splay_set empty;
+    empty.join (upper);
+    EXPECT_TRUE (upper.empty ());
+    EXPECT_EQ (*empty.begin (), 3);
+    lower.join (splay_set {});
+    EXPECT_EQ (lower.size (), 3);
+}
+
+// nodes of a set with its own arena move over, ones in a shared arena are copied
+TEST (test_splay_set, join_separate_storage)
+{
+    splay_set tree {1, 2, 3};
+    {
+        splay_set own {10, 11, 12};
+        tree.join (own);
+    }
+    splay_set other {5, 6, 20, 21};
+    auto shared = other.split (20);
+    tree.join (shared);
+    EXPECT_TRUE (shared.empty ());
+    EXPECT_EQ (other.size (), 2);
+    other.clear ();
+
+    std::vector<int> expected {1, 2, 3, 10, 11, 12, 20, 21};
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), expected.begin (), expected.end ()));
+    tree.insert (30);
+    tree.erase (11);
+    EXPECT_EQ (tree.size (), 8);
+
+    using std_alloc_set =
+        red::containers::splay_dynamic_order_set<int, std::less<int>, std::allocator<int>>;
+    std_alloc_set lower {1, 2}, upper {3};
+    lower.join (lower.split (2));
+    lower.join (upper);
+    EXPECT_EQ (lower.size (), 3);
+}
+
+// rebound copies share the arena, so memory can go back through any of them
+TEST (test_splay_set, arena_rebind)
+{
+    using red::containers::node_arena;
+    node_arena<int> ints;
+    node_arena<std::string> strings {ints};
+    node_arena<int> back {strings};
+    EXPECT_EQ (back, ints);
+    EXPECT_EQ (strings, node_arena<std::string> {ints});
+    EXPECT_FALSE (ints == node_arena<int> {});
+
+    auto str = strings.allocate (1);
+    node_arena<std::string> {back}.deallocate (str, 1);
+    auto moved = std::move (strings);
+    EXPECT_EQ (moved, strings);
+
+    splay_set tree {1, 2, 3};
+    EXPECT_EQ (splay_set::allocator_type {tree.get_allocator ()}, tree.get_allocator ());
+    splay_set moved_tree {std::move (tree)};
+    EXPECT_EQ (moved_tree.size (), 3);
+    tree = splay_set {4};
+    EXPECT_EQ (tree.size (), 1);
+}
+
+template <typename Set_t> void check_range_erase ()
+{
+    std::mt19937 gen (7);
+    std::uniform_int_distribution<int> key_dist (0, 1200);
+    std::vector<int> keys (1000);
+    std::iota (keys.begin (), keys.end (), 0);
+    for ( int round = 0; round < 200; ++round )
+    {
+        Set_t tree (keys.begin (), keys.end ());
+        std::set<int> std_set (keys.begin (), keys.end ());
+        for ( int i = 0; i < 5; ++i )
+        {
+            auto lo = key_dist (gen), hi = key_dist (gen);
+            auto first = std_set.lower_bound (lo), last = std_set.upper_bound (hi);
+            auto expected = (hi < lo ? 0 : std::distance (first, last));
+            if ( hi >= lo )
+                std_set.erase (first, last);
+            if ( i % 2 )
+            {
+                ASSERT_EQ (tree.erase (lo, hi), expected);
+            }
+            else if ( hi >= lo )
+            {
+                ASSERT_EQ (tree.erase (tree.lower_bound (lo), tree.upper_bound (hi)), expected);
+            }
+        }
+        ASSERT_EQ (tree.size (), std_set.size ());
+        ASSERT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+        ASSERT_TRUE (std::equal (tree.rbegin (), tree.rend (), std_set.rbegin (), std_set.rend ()));
+        for ( std::size_t rank = 1; rank <= std_set.size (); rank += 37 )
+            ASSERT_EQ (*tree.os_select (rank), *std::next (std_set.begin (), rank - 1));
+        tree.insert (-1);
+        tree.insert (5000);
+        EXPECT_EQ (*tree.begin (), -1);
+        EXPECT_EQ (*tree.rbegin (), 5000);
+    }
+}
+
+TEST (test_splay_set, range_erase)
+{
+    check_range_erase<splay_set> ();
+    check_range_erase<top_down_set> ();
+
+    splay_set tree {1, 2, 3, 4, 5};
+    EXPECT_EQ (tree.erase (tree.begin (), tree.begin ()), 0);
+    EXPECT_EQ (tree.erase (4, 2), 0);
+    EXPECT_EQ (tree.erase (tree.begin (), tree.end ()), 5);
+    EXPECT_TRUE (tree.empty ());
+    EXPECT_EQ (tree.erase (0, 10), 0);
+}
+
+// key that counts its copies and moves
+struct counted_key
+{
+    int m_value = 0;
+
+    static inline int copies = 0;
+    static inline int moves  = 0;
+
+    counted_key (int value) : m_value {value} {}
+    counted_key (const counted_key &rhs) : m_value {rhs.m_value} { ++copies; }
+    counted_key (counted_key &&rhs) noexcept : m_value {rhs.m_value} { ++moves; }
+    counted_key &operator= (const counted_key &rhs)
+    {
+        m_value = rhs.m_value;
+        ++copies;
+        return *this;
+    }
+    counted_key &operator= (counted_key &&rhs) noexcept
+    {
+        m_value = rhs.m_value;
+        ++moves;
+        return *this;
+    }
+
+    friend bool operator== (const counted_key &, const counted_key &) = default;
+    friend auto operator<=> (const counted_key &, const counted_key &) = default;
+};
+
+template <typename Set_t> void check_no_key_copies ()
+{
+    Set_t tree;
+    counted_key::copies = counted_key::moves = 0;
+    for ( int i = 0; i < 100; ++i )
+        tree.emplace ((i * 37) % 100);
+    EXPECT_EQ (counted_key::copies, 0);
+    EXPECT_EQ (counted_key::moves, 0);
+
+    for ( int i = 100; i < 200; ++i )
+        tree.insert (counted_key {i});
+    EXPECT_EQ (counted_key::moves, 100);
+    EXPECT_THROW (tree.emplace (5), std::out_of_range);
+    EXPECT_EQ (tree.size (), 200);
+
+    counted_key key {42}, missing {1000};
+    EXPECT_NE (tree.find (key), tree.end ());
+    EXPECT_EQ (tree.find (missing), tree.end ());
+    tree.lower_bound (key);
+    tree.upper_bound (key);
+    EXPECT_EQ (tree.get_number_less_then (key), 42);
+    EXPECT_EQ (tree.count_in_range (key, missing), 158);
+    tree.erase (key);
+    EXPECT_EQ (counted_key::copies, 0);
+}
+
+TEST (test_splay_set, no_key_copies)
+{
+    check_no_key_copies<red::containers::dynamic_order_set<counted_key>> ();
+    check_no_key_copies<red::containers::splay_dynamic_order_set<counted_key>> ();
+    check_no_key_copies<red::containers::splay_dynamic_order_set<
+        counted_key, std::less<counted_key>, red::containers::node_arena<counted_key>,
+        red::containers::top_down_splay>> ();
+}
+
+// std::string_view does not convert to std::string implicitly, so every lookup below only compiles
+// if it reaches the comparator as is
+template <typename Set_t> void check_heterogeneous_lookup ()
+{
+    using namespace std::string_view_literals;
+    Set_t tree;
+    for ( auto word : {"apple", "banana", "cherry", "date", "elder", "fig"} )
+        tree.emplace (word);
+
+    EXPECT_EQ (*tree.find ("cherry"sv), "cherry");
+    EXPECT_EQ (tree.find ("grape"sv), tree.end ());
+    EXPECT_EQ (*tree.lower_bound ("c"sv), "cherry");
+    EXPECT_EQ (*tree.upper_bound ("date"sv), "elder");
+    EXPECT_EQ (tree.get_number_less_then ("d"sv), 3);
+    EXPECT_EQ (tree.count_less ("date"sv), 3);
+    EXPECT_EQ (tree.count_greater ("date"sv), 2);
+    EXPECT_EQ (tree.count_in_range ("b"sv, "e"sv), 3);
+    EXPECT_EQ (tree.count_in_range ("banana"sv, std::string {"elder"}), 4);
+
+    tree.erase ("banana"sv);
+    EXPECT_EQ (tree.size (), 5);
+    EXPECT_EQ (tree.find ("banana"sv), tree.end ());
+    EXPECT_EQ (tree.count_less ("c"), 1);
+}
+
+TEST (test_splay_set, heterogeneous_lookup)
+{
+    using red::containers::node_arena;
+    check_heterogeneous_lookup<
+        red::containers::dynamic_order_set<std::string, std::less<>, node_arena<std::string>>> ();
+    check_heterogeneous_lookup<
+        red::containers::splay_dynamic_order_set<std::string, std::less<>>> ();
+    check_heterogeneous_lookup<red::containers::splay_dynamic_order_set<
+        std::string, std::less<>, node_arena<std::string>, red::containers::top_down_splay>> ();
+
+    using namespace std::string_view_literals;
+    red::containers::splay_dynamic_order_set<std::string, std::less<>> tree {"a", "b", "c"};
+    auto view = tree.frozen_view ();
+    EXPECT_TRUE (view.contains ("b"sv));
+    EXPECT_EQ (view.count_in_range ("a"sv, "b"sv), 2);
+    auto upper = tree.split ("b"sv);
+    EXPECT_EQ (upper.size (), 2);
+    EXPECT_EQ (upper.erase ("a"sv, "z"sv), 2);
+    EXPECT_TRUE (upper.empty ());
+    EXPECT_EQ (tree.size (), 1);
+
+    // without a transparent comparator arguments are converted to the key type as before
+    red::containers::splay_dynamic_order_set<long> longs {1, 2, 3};
+    EXPECT_NE (longs.find (2), longs.end ());
+    EXPECT_EQ (longs.count_in_range (1, 2l), 2);
+    longs.erase (3);
+    EXPECT_EQ (longs.size (), 2);
+}
+
+// three-way comparator counting its calls
+struct counting_three_way
+{
+    static inline std::size_t calls = 0;
+
+    std::strong_ordering operator() (int lhs, int rhs) const
+    {
+        ++calls;
+        return lhs <=> rhs;
+    }
+};
+
+TEST (test_splay_set, three_way_descent)
+{
+    // sorted inserts into an unbalanced tree make a path, every descent to the bottom takes one
+    // comparison per node
+    red::containers::dynamic_order_set<int, counting_three_way, red::containers::node_arena<int>>
+        path;
+    for ( int i = 0; i < 64; ++i )
+        path.insert (i);
+    counting_three_way::calls = 0;
+    EXPECT_EQ (*path.find (63), 63);
+    EXPECT_EQ (counting_three_way::calls, 64);
+
+    // failed updates undo their size steps without descending again
+    counting_three_way::calls = 0;
+    EXPECT_THROW (path.insert (63), std::out_of_range);
+    EXPECT_EQ (counting_three_way::calls, 64);
+    EXPECT_THROW (path.erase (64), std::out_of_range);
+    EXPECT_EQ (counting_three_way::calls, 128);
+    EXPECT_EQ (path.size (), 64);
+    for ( int i = 0; i < 64; i += 7 )
+    {
+        EXPECT_EQ (*path.os_select (i + 1), i);
+        EXPECT_EQ (path.get_rank_of (path.find (i)), i + 1);
+    }
+
+    red::containers::splay_dynamic_order_set<int, counting_three_way> tree;
+    std::set<int> std_set;
+    std::mt19937 gen (7);
+    for ( int i = 0; i < 2000; ++i )
+    {
+        int key = gen () % 500;
+        if ( gen () % 3 )
+        {
+            if ( std_set.insert (key).second )
+                tree.insert (key);
+            else
+                EXPECT_THROW (tree.insert (key), std::out_of_range);
+        }
+        else if ( std_set.erase (key) )
+            tree.erase (key);
+        else
+            EXPECT_THROW (tree.erase (key), std::out_of_range);
+    }
+    EXPECT_TRUE (std::equal (tree.begin (), tree.end (), std_set.begin (), std_set.end ()));
+    EXPECT_EQ (*tree.lower_bound (250), *std_set.lower_bound (250));
+    EXPECT_EQ (*tree.upper_bound (250), *std_set.upper_bound (250));
+    EXPECT_EQ (tree.count_less (250), std::distance (std_set.begin (), std_set.lower_bound (250)));
+
+    // top-down updates reuse the last comparison of the splay, a sorted insert after the root
+    // takes exactly one
+    red::containers::splay_dynamic_order_set<int, counting_three_way,
+                                             red::containers::node_arena<int>,
+                                             red::containers::top_down_splay>
+        top_down;
+    counting_three_way::calls = 0;
+    for ( int i = 0; i < 64; ++i )
+        top_down.insert (i);
+    EXPECT_EQ (counting_three_way::calls, 63);
+    counting_three_way::calls = 0;
+    EXPECT_EQ (*top_down.find (63), 63);
+    EXPECT_EQ (*top_down.lower_bound (63), 63);
+    EXPECT_EQ (top_down.upper_bound (63), top_down.end ());
+    EXPECT_EQ (counting_three_way::calls, 3);
+
+    // std::greater descends with the reversed built-in <=>
+    red::containers::splay_dynamic_order_set<int, std::greater<int>> desc {3, 1, 2};
+    EXPECT_EQ (*desc.begin (), 3);
+    EXPECT_NE (desc.find (1), desc.end ());
+    desc.erase (2);
+    EXPECT_EQ (desc.count_less (2), 1);
+}
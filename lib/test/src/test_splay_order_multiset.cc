@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "splay_order_multiset.hpp"
+
+template struct red::containers::splay_order_multiset<int>;
+
+using multiset = red::containers::splay_order_multiset<int>;
+
+namespace
+{
+
+template <typename Splay_t>
+using policy_multiset = red::containers::splay_order_multiset<int, std::less<int>,
+                                                              red::containers::node_arena<int>,
+                                                              Splay_t>;
+
+// the multiset written out with the duplicates
+template <typename Set_t> std::vector<int> expand (const Set_t &tree)
+{
+    std::vector<int> res;
+    for ( auto pos = tree.begin (); pos != tree.end (); ++pos )
+        res.insert (res.end (), tree.multiplicity (pos), *pos);
+    return res;
+}
+
+template <typename Set_t> void check_queries (Set_t &tree, const std::multiset<int> &std_set)
+{
+    ASSERT_EQ (tree.size (), std_set.size ());
+    ASSERT_EQ (expand (tree), std::vector<int> (std_set.begin (), std_set.end ()));
+    std::set<int> distinct (std_set.begin (), std_set.end ());
+    ASSERT_EQ (std::distance (tree.begin (), tree.end ()), distinct.size ());
+
+    for ( int key = -1; key <= 101; key += 3 )
+    {
+        auto less = std::distance (std_set.begin (), std_set.lower_bound (key));
+        EXPECT_EQ (tree.count (key), std_set.count (key));
+        EXPECT_EQ (tree.count_less (key), less);
+        EXPECT_EQ (tree.get_number_less_then (key), less);
+        EXPECT_EQ (tree.count_greater (key),
+                   std::distance (std_set.upper_bound (key), std_set.end ()));
+        EXPECT_EQ (tree.count_in_range (key, key + 10),
+                   std::distance (std_set.lower_bound (key), std_set.upper_bound (key + 10)));
+        auto found = tree.find (key);
+        if ( found != tree.end () )
+        {
+            EXPECT_EQ (tree.get_rank_of (found), less + 1);
+        }
+    }
+    for ( std::size_t rank = 1; rank <= std_set.size (); rank += 7 )
+        EXPECT_EQ (*tree.os_select (rank), *std::next (std_set.begin (), rank - 1));
+    EXPECT_EQ (tree.os_select (std_set.size () + 1), tree.end ());
+}
+
+template <typename Set_t> void check_against_std_multiset ()
+{
+    Set_t tree;
+    std::multiset<int> std_set;
+    std::mt19937 gen {5};
+    std::uniform_int_distribution<int> dist {0, 100};
+    for ( int i = 0; i < 4000; ++i )
+    {
+        auto key = dist (gen);
+        switch ( gen () % 5 )
+        {
+        case 0:
+            if ( std_set.count (key) )
+            {
+                EXPECT_EQ (tree.erase (key), std_set.erase (key));
+            }
+            else
+                EXPECT_THROW (tree.erase (key), std::out_of_range);
+            break;
+        case 1:
+            if ( auto found = std_set.find (key); found != std_set.end () )
+            {
+                tree.erase (tree.find (key));
+                std_set.erase (found);
+            }
+            break;
+        default:
+            tree.insert (key);
+            std_set.insert (key);
+        }
+        if ( i % 500 == 0 )
+            check_queries (tree, std_set);
+    }
+    check_queries (tree, std_set);
+
+    // range erase counts the duplicates
+    EXPECT_EQ (tree.erase (20, 40),
+               std::distance (std_set.lower_bound (20), std_set.upper_bound (40)));
+    std_set.erase (std_set.lower_bound (20), std_set.upper_bound (40));
+    check_queries (tree, std_set);
+
+    Set_t copy {tree};
+    check_queries (copy, std_set);
+
+    auto upper = tree.split (60);
+    EXPECT_EQ (upper.size (), std::distance (std_set.lower_bound (60), std_set.end ()));
+    upper.insert (70);
+    tree.join (upper);
+    std_set.insert (70);
+    check_queries (tree, std_set);
+    EXPECT_TRUE (upper.empty ());
+}
+
+}   // namespace
+
+TEST (test_splay_order_multiset, ctor)
+{
+    multiset tree {3, 1, 3, 2, 3};
+    EXPECT_EQ (tree.size (), 5);
+    EXPECT_EQ (tree.count (3), 3);
+    EXPECT_EQ (tree.count (4), 0);
+    EXPECT_EQ (std::distance (tree.begin (), tree.end ()), 3);
+
+    std::vector<int> keys {5, 5, 4};
+    tree.assign (keys.begin (), keys.end ());
+    EXPECT_EQ (tree.size (), 3);
+    EXPECT_EQ (tree.count (5), 2);
+}
+
+TEST (test_splay_order_multiset, bulk_build)
+{
+    std::mt19937 gen {11};
+    std::vector<int> keys (3000);
+    for ( auto &key : keys )
+        key = static_cast<int> (gen () % 200);
+    std::multiset<int> std_set (keys.begin (), keys.end ());
+
+    multiset unsorted (keys.begin (), keys.end ());
+    check_queries (unsorted, std_set);
+
+    std::sort (keys.begin (), keys.end ());
+    multiset sorted;
+    sorted.assign (keys.begin (), keys.end ());
+    check_queries (sorted, std_set);
+    EXPECT_EQ (expand (sorted), keys);
+
+    std::istringstream text {"4 1 4 4 2"};
+    multiset streamed (std::istream_iterator<int> {text}, std::istream_iterator<int> {});
+    EXPECT_EQ (expand (streamed), (std::vector<int> {1, 2, 4, 4, 4}));
+    streamed.insert (4);
+    streamed.erase (streamed.find (1));
+    EXPECT_EQ (streamed.count (4), 4);
+    EXPECT_EQ (*streamed.os_select (1), 2);
+
+    sorted.assign ({});
+    EXPECT_TRUE (sorted.empty ());
+}
+
+TEST (test_splay_order_multiset, matches_std_multiset)
+{
+    check_against_std_multiset<policy_multiset<red::containers::bottom_up_splay>> ();
+    check_against_std_multiset<policy_multiset<red::containers::top_down_splay>> ();
+    check_against_std_multiset<policy_multiset<red::containers::semi_splay>> ();
+    check_against_std_multiset<policy_multiset<red::containers::depth_threshold_splay>> ();
+}
+
+TEST (test_splay_order_multiset, erase_one_and_all)
+{
+    multiset tree {1, 2, 2, 2, 3};
+    tree.erase (tree.find (2));
+    EXPECT_EQ (tree.count (2), 2);
+    EXPECT_EQ (tree.size (), 4);
+    EXPECT_EQ (*tree.os_select (3), 2);
+    EXPECT_EQ (*tree.os_select (4), 3);
+
+    EXPECT_EQ (tree.erase (2), 2);
+    EXPECT_EQ (tree.size (), 2);
+    EXPECT_EQ (tree.find (2), tree.end ());
+    EXPECT_THROW (tree.erase (2), std::out_of_range);
+
+    tree.erase (tree.find (1));
+    tree.erase (tree.find (3));
+    EXPECT_TRUE (tree.empty ());
+}
+
+TEST (test_splay_order_multiset, join_separate_storage)
+{
+    multiset lower {1, 1, 2};
+    multiset upper {5, 5, 5};
+    auto shared = upper.split (0);   // shares the storage of upper, so upper cannot give it away
+    lower.join (shared);
+    EXPECT_EQ (lower.size (), 6);
+    EXPECT_EQ (lower.count (5), 3);
+    EXPECT_EQ (*lower.os_select (6), 5);
+    EXPECT_TRUE (shared.empty ());
+
+    multiset smaller {0};
+    EXPECT_THROW (lower.join (smaller), std::out_of_range);
+}
+
+TEST (test_splay_order_multiset, failed_join_keeps_both_sets)
+{
+    using string_multiset = red::containers::splay_order_multiset<std::string>;
+    auto other = std::make_unique<string_multiset> (
+        std::initializer_list<std::string> {"a", "b", std::string (64, 'z')});
+    auto lower = std::make_unique<string_multiset> (std::initializer_list<std::string> {"m", "n"});
+    lower->insert ("m");
+    EXPECT_THROW (lower->join (*other), std::out_of_range);
+    EXPECT_EQ (lower->size (), 3);
+    EXPECT_EQ (lower->count ("m"), 2);
+    EXPECT_EQ (other->size (), 3);
+    EXPECT_EQ (*other->os_select (3), std::string (64, 'z'));
+
+    // other must not depend on the storage of lower
+    lower.reset ();
+    EXPECT_EQ (other->count ("a"), 1);
+    other.reset ();
+
+    multiset ints {1, 2, 3}, overlapping {3, 4};
+    EXPECT_THROW (ints.join (overlapping), std::out_of_range);
+    EXPECT_EQ (ints.size (), 3);
+    EXPECT_EQ (overlapping.size (), 2);
+    overlapping.insert (4);
+    EXPECT_EQ (overlapping.count (4), 2);
+}
@@ -0,0 +1,197 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// order statistic structures the splay sets are compared with
+
+#pragma once
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace red
+{
+namespace baselines
+{
+
+// All of them have the interface the benchmark needs: construction from a range of keys,
+// insert, erase and count_in_range (lo, hi) for lo <= hi.
+
+// red-black tree of GNU pb_ds with subtree sizes
+template <typename T, class Compare_t = std::less<T>> class pbds_order_set
+{
+    __gnu_pbds::tree<T, __gnu_pbds::null_type, Compare_t, __gnu_pbds::rb_tree_tag,
+                     __gnu_pbds::tree_order_statistics_node_update>
+        m_tree;
+
+  public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    pbds_order_set () = default;
+
+    template <std::input_iterator It> pbds_order_set (It first, It last)
+    {
+        for ( ; first != last; ++first )
+            m_tree.insert (*first);
+    }
+
+    size_type size () const { return m_tree.size (); }
+
+    void insert (const value_type &key) { m_tree.insert (key); }
+
+    void erase (const value_type &key) { m_tree.erase (key); }
+
+    size_type count_in_range (const value_type &lo, const value_type &hi) const
+    {
+        auto not_greater = m_tree.order_of_key (hi) + (m_tree.find (hi) != m_tree.end ());
+        return not_greater - m_tree.order_of_key (lo);
+    }
+};
+
+// sorted array of unique keys, O(log n) queries and O(n) updates
+template <typename T, class Compare_t = std::less<T>> class sorted_vector_set
+{
+    std::vector<T> m_keys;
+    Compare_t m_compare;
+
+  public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    sorted_vector_set () = default;
+
+    template <std::input_iterator It> sorted_vector_set (It first, It last) : m_keys (first, last)
+    {
+        std::sort (m_keys.begin (), m_keys.end (), m_compare);
+        auto equal = [this] (const T &lhs, const T &rhs) {
+            return !m_compare (lhs, rhs) && !m_compare (rhs, lhs);
+        };
+        m_keys.erase (std::unique (m_keys.begin (), m_keys.end (), equal), m_keys.end ());
+    }
+
+    size_type size () const { return m_keys.size (); }
+
+    void insert (const value_type &key)
+    {
+        auto pos = std::lower_bound (m_keys.begin (), m_keys.end (), key, m_compare);
+        if ( pos == m_keys.end () || m_compare (key, *pos) )
+            m_keys.insert (pos, key);
+    }
+
+    void erase (const value_type &key)
+    {
+        auto pos = std::lower_bound (m_keys.begin (), m_keys.end (), key, m_compare);
+        if ( pos != m_keys.end () && !m_compare (key, *pos) )
+            m_keys.erase (pos);
+    }
+
+    size_type count_in_range (const value_type &lo, const value_type &hi) const
+    {
+        auto first = std::lower_bound (m_keys.begin (), m_keys.end (), lo, m_compare);
+        auto last  = std::upper_bound (first, m_keys.end (), hi, m_compare);
+        return static_cast<size_type> (last - first);
+    }
+};
+
+// Fenwick tree of presence flags over the sorted keys given at construction. The key universe is
+// fixed: only those keys can be inserted back after an erase, other ones throw
+// std::out_of_range. Every operation is O(log n).
+template <typename T, class Compare_t = std::less<T>> class fenwick_order_set
+{
+    std::vector<T> m_coords;
+    std::vector<std::size_t> m_tree;   // m_tree[i] counts the present keys in (i - lsb (i), i]
+    std::vector<bool> m_present;
+    std::size_t m_size = 0;
+    Compare_t m_compare;
+
+    // number of present keys among the first n coordinates
+    std::size_t prefix (std::size_t n) const
+    {
+        std::size_t res = 0;
+        for ( ; n; n &= n - 1 )
+            res += m_tree[n];
+        return res;
+    }
+
+    void add (std::size_t idx, bool inc)
+    {
+        for ( ++idx; idx < m_tree.size (); idx += idx & (0 - idx) )
+            m_tree[idx] = (inc ? m_tree[idx] + 1 : m_tree[idx] - 1);
+    }
+
+    std::size_t coord_of (const T &key) const
+    {
+        auto pos = std::lower_bound (m_coords.begin (), m_coords.end (), key, m_compare);
+        if ( pos == m_coords.end () || m_compare (key, *pos) )
+            return m_coords.size ();
+        return static_cast<std::size_t> (pos - m_coords.begin ());
+    }
+
+  public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    template <std::input_iterator It> fenwick_order_set (It first, It last) : m_coords (first, last)
+    {
+        std::sort (m_coords.begin (), m_coords.end (), m_compare);
+        auto equal = [this] (const T &lhs, const T &rhs) {
+            return !m_compare (lhs, rhs) && !m_compare (rhs, lhs);
+        };
+        m_coords.erase (std::unique (m_coords.begin (), m_coords.end (), equal), m_coords.end ());
+
+        // every key is present, so node i counts lsb (i) keys
+        m_size = m_coords.size ();
+        m_present.assign (m_size, true);
+        m_tree.resize (m_size + 1);
+        for ( std::size_t i = 1; i <= m_size; ++i )
+            m_tree[i] = i & (0 - i);
+    }
+
+    size_type size () const { return m_size; }
+
+    void insert (const value_type &key)
+    {
+        auto idx = coord_of (key);
+        if ( idx == m_coords.size () )
+            throw std::out_of_range ("Key is out of the fenwick_order_set universe");
+        if ( m_present[idx] )
+            return;
+        m_present[idx] = true;
+        ++m_size;
+        add (idx, true);
+    }
+
+    void erase (const value_type &key)
+    {
+        auto idx = coord_of (key);
+        if ( idx == m_coords.size () || !m_present[idx] )
+            return;
+        m_present[idx] = false;
+        --m_size;
+        add (idx, false);
+    }
+
+    size_type count_in_range (const value_type &lo, const value_type &hi) const
+    {
+        auto first = std::lower_bound (m_coords.begin (), m_coords.end (), lo, m_compare);
+        auto last  = std::upper_bound (first, m_coords.end (), hi, m_compare);
+        return prefix (static_cast<std::size_t> (last - m_coords.begin ())) -
+               prefix (static_cast<std::size_t> (first - m_coords.begin ()));
+    }
+};
+
+}   // namespace baselines
+}   // namespace red
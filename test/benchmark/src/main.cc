@@ -7,38 +7,96 @@
  * ----------------------------------------------------------------------------
  */
 
+#include "baselines.hpp"
+#include "compact_splay_order_set.hpp"
+#include "fast_io.hpp"
 #include "splay_dynamic_order_set.hpp"
+#include "workload.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <set>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-std::chrono::duration<double, std::milli>
-queries_splay (const std::vector<int> &elements, const std::vector<std::pair<int, int>> &bounds)
-{
-    red::containers::splay_dynamic_order_set<int> set {};
+using splay_set = red::containers::splay_dynamic_order_set<int>;
+using top_down_splay_set =
+    red::containers::splay_dynamic_order_set<int, std::less<int>, red::containers::node_arena<int>,
+                                             red::containers::top_down_splay>;
+using compact_splay_set = red::containers::compact_splay_order_set<int>;
+using pbds_set          = red::baselines::pbds_order_set<int>;
+using sorted_vector_set = red::baselines::sorted_vector_set<int>;
+using fenwick_set       = red::baselines::fenwick_order_set<int>;
 
-    for ( auto elem : elements )
-        set.insert (elem);
+using elements_t = std::span<const std::int32_t>;
+using queries_t  = std::span<const red::io::range_query>;
+
+template <typename Set_t>
+std::chrono::duration<double, std::milli> queries_set (elements_t elements, queries_t bounds)
+{
+    Set_t set (elements.begin (), elements.end ());
 
     auto splay_start = std::chrono::high_resolution_clock::now ();
     for ( auto elem : bounds )
     {
         auto [l_bound, r_bound] = elem;
-        auto it_l               = set.lower_bound (l_bound);
-        auto it_r               = set.upper_bound (r_bound);
-
-        auto l_rank = (it_l == set.end () ? 0 : set.get_rank_of (it_l));
-        auto r_rank = (it_r == set.end () ? 0 : set.get_rank_of (it_r));
-        auto res    = r_rank - l_rank;
+        auto res                = set.count_in_range (l_bound, r_bound);
         asm("" ::"r"(res));
     }
     auto splay_finish = std::chrono::high_resolution_clock::now ();
     return std::chrono::duration<double, std::milli> (splay_finish - splay_start);
 }
 
+// the same queries answered in one batch
+template <typename Set_t>
+std::chrono::duration<double, std::milli> queries_batch (elements_t elements, queries_t bounds)
+{
+    Set_t set (elements.begin (), elements.end ());
+
+    auto batch_start = std::chrono::high_resolution_clock::now ();
+    auto res         = set.count_in_ranges (bounds);
+    asm("" ::"r"(res.data ()));
+    auto batch_finish = std::chrono::high_resolution_clock::now ();
+    return std::chrono::duration<double, std::milli> (batch_finish - batch_start);
+}
+
+// time to fill an empty set with the elements one by one and to build it from the whole range.
+template <typename Set_t>
+std::pair<std::chrono::duration<double, std::milli>, std::chrono::duration<double, std::milli>>
+build_splay (elements_t elements)
+{
+    auto insert_start = std::chrono::high_resolution_clock::now ();
+    {
+        Set_t set {};
+        set.reserve (elements.size ());
+        for ( auto elem : elements )
+            set.insert (elem);
+    }
+    auto insert_finish = std::chrono::high_resolution_clock::now ();
+    {
+        Set_t set (elements.begin (), elements.end ());
+    }
+    auto range_finish = std::chrono::high_resolution_clock::now ();
+    return {insert_finish - insert_start, range_finish - insert_finish};
+}
+
+// erase-heavy workload: fill the set, then erase every element in input order.
+template <typename Set_t>
+std::chrono::duration<double, std::milli> erase_set (elements_t elements)
+{
+    Set_t set (elements.begin (), elements.end ());
+
+    auto splay_start = std::chrono::high_resolution_clock::now ();
+    for ( auto elem : elements )
+        set.erase (elem);
+    auto splay_finish = std::chrono::high_resolution_clock::now ();
+    return std::chrono::duration<double, std::milli> (splay_finish - splay_start);
+}
+
 int get_number_in_range (std::set<int> &set, const int l_bound, const int r_bound)
 {
     auto lb = set.lower_bound (l_bound);
@@ -46,8 +104,7 @@ int get_number_in_range (std::set<int> &set, const int l_bound, const int r_boun
     return std::distance (lb, ub);
 }
 
-std::chrono::duration<double, std::milli>
-queries_stl (const std::vector<int> &elements, const std::vector<std::pair<int, int>> &bounds)
+std::chrono::duration<double, std::milli> queries_stl (elements_t elements, queries_t bounds)
 {
     std::set<int> set {};
 
@@ -65,48 +122,143 @@ queries_stl (const std::vector<int> &elements, const std::vector<std::pair<int,
     return std::chrono::duration<double, std::milli> (stl_finish - stl_start);
 }
 
-std::pair<std::vector<int>, std::vector<std::pair<int, int>>> input ()
+std::chrono::duration<double, std::milli> erase_stl (elements_t elements)
 {
-    unsigned n_elems {};
-    std::cin >> n_elems;
-    assert (std::cin.good ());
+    std::set<int> set {};
 
-    std::vector<int> elements;
-    elements.reserve (n_elems);
+    for ( auto elem : elements )
+        set.insert (elem);
 
-    for ( ; n_elems > 0; --n_elems )
-    {
-        int key;
-        std::cin >> key;
-        assert (std::cin.good ());
-        elements.push_back (key);
-    }
+    auto stl_start = std::chrono::high_resolution_clock::now ();
+    for ( auto elem : elements )
+        set.erase (elem);
+    auto stl_finish = std::chrono::high_resolution_clock::now ();
+    return std::chrono::duration<double, std::milli> (stl_finish - stl_start);
+}
 
-    unsigned n_requests {};
-    std::cin >> n_requests;
-    assert (std::cin.good ());
+struct measurement
+{
+    std::string_view structure;
+    std::string_view operation;
+    double ms;
+};
 
-    std::vector<std::pair<int, int>> bounds;
-    bounds.reserve (2 * n_requests);
+enum class output_format
+{
+    text,
+    csv,
+    json,
+};
 
-    for ( ; n_requests > 0; --n_requests )
+std::string_view describe (std::string_view operation)
+{
+    if ( operation == "parse" )
+        return "parse";
+    if ( operation == "queries" )
+        return "run";
+    if ( operation == "queries_batch" )
+        return "run in one batch";
+    if ( operation == "erase" )
+        return "erase all elements";
+    if ( operation == "insert_build" )
+        return "insert all elements";
+    return "build from the range";
+}
+
+// CSV starts with a header line, JSON is one object per line (JSON Lines), so the outputs of
+// several runs can be concatenated.
+void print_results (const std::vector<measurement> &results, output_format format,
+                    std::string_view workload_name, elements_t elements, queries_t bounds)
+{
+    if ( format == output_format::csv )
+        std::cout << "workload,structure,operation,n_elements,n_queries,ms\n";
+    for ( auto [structure, operation, ms] : results )
     {
-        int bound1 {}, bound2 {}, l_bound {}, r_bound {};
-        std::cin >> bound1 >> bound2;
-        assert (std::cin.good ());
-        l_bound = std::min (bound1, bound2);
-        r_bound = std::max (bound1, bound2);
-        bounds.push_back ({l_bound, r_bound});
+        switch ( format )
+        {
+        case output_format::text:
+            std::cout << "\t" << structure << " took " << ms << "ms to " << describe (operation)
+                      << "\n";
+            break;
+        case output_format::csv:
+            std::cout << workload_name << "," << structure << "," << operation << ","
+                      << elements.size () << "," << bounds.size () << "," << ms << "\n";
+            break;
+        case output_format::json:
+            std::cout << "{\"workload\": \"" << workload_name << "\", \"structure\": \""
+                      << structure << "\", \"operation\": \"" << operation
+                      << "\", \"n_elements\": " << elements.size ()
+                      << ", \"n_queries\": " << bounds.size () << ", \"ms\": " << ms << "}\n";
+            break;
+        }
     }
-    return {elements, bounds};
+    if ( format == output_format::text )
+        std::cout << std::endl;
 }
 
-int main ()
+// usage: benchmark [--format=text|csv|json] [--workload=<name>] < workload
+// The workload name only labels the CSV and JSON records.
+int main (int argc, char **argv)
 {
-    auto [elements, bounds] = input ();
-    auto splay_duration     = queries_splay (elements, bounds);
-    auto stl_duration       = queries_stl (elements, bounds);
-    std::cout << "\tred::container::splay_set took " << splay_duration.count () << "ms to run\n";
-    std::cout << "\tstd::set took " << stl_duration.count () << "ms to run\n";
-    std::cout << std::endl;
-}
\ No newline at end of file
+    auto format                    = output_format::text;
+    std::string_view workload_name = "stdin";
+    for ( int i = 1; i < argc; ++i )
+    {
+        std::string_view arg = argv[i];
+        if ( arg == "--format=text" )
+            format = output_format::text;
+        else if ( arg == "--format=csv" )
+            format = output_format::csv;
+        else if ( arg == "--format=json" )
+            format = output_format::json;
+        else if ( arg.starts_with ("--workload=") )
+            workload_name = arg.substr (std::string_view {"--workload="}.size ());
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--format=text|csv|json] [--workload=<name>] < workload\n";
+            return 1;
+        }
+    }
+
+    auto parse_start = std::chrono::high_resolution_clock::now ();
+    red::io::input_buffer in {};
+    red::io::workload load {in};
+    auto elements = load.elements ();
+    auto bounds   = load.queries ();
+    std::chrono::duration<double, std::milli> parse_duration =
+        std::chrono::high_resolution_clock::now () - parse_start;
+
+    std::vector<measurement> results;
+    auto add = [&results] (std::string_view structure, std::string_view operation,
+                           std::chrono::duration<double, std::milli> duration) {
+        results.push_back ({structure, operation, duration.count ()});
+    };
+
+    add ("input", "parse", parse_duration);
+    add ("red::containers::splay_set", "queries", queries_set<splay_set> (elements, bounds));
+    add ("red::containers::splay_set (top-down)", "queries",
+         queries_set<top_down_splay_set> (elements, bounds));
+    add ("red::containers::compact_splay_set", "queries",
+         queries_set<compact_splay_set> (elements, bounds));
+    add ("red::containers::splay_set", "queries_batch",
+         queries_batch<splay_set> (elements, bounds));
+    add ("__gnu_pbds::tree", "queries", queries_set<pbds_set> (elements, bounds));
+    add ("sorted std::vector", "queries", queries_set<sorted_vector_set> (elements, bounds));
+    add ("fenwick tree", "queries", queries_set<fenwick_set> (elements, bounds));
+    add ("std::set", "queries", queries_stl (elements, bounds));
+
+    add ("red::containers::splay_set", "erase", erase_set<splay_set> (elements));
+    add ("red::containers::splay_set (top-down)", "erase",
+         erase_set<top_down_splay_set> (elements));
+    add ("__gnu_pbds::tree", "erase", erase_set<pbds_set> (elements));
+    add ("sorted std::vector", "erase", erase_set<sorted_vector_set> (elements));
+    add ("fenwick tree", "erase", erase_set<fenwick_set> (elements));
+    add ("std::set", "erase", erase_stl (elements));
+
+    auto [splay_insert_build, splay_range_build] = build_splay<splay_set> (elements);
+    add ("red::containers::splay_set", "insert_build", splay_insert_build);
+    add ("red::containers::splay_set", "range_build", splay_range_build);
+
+    print_results (results, format, workload_name, elements, bounds);
+}
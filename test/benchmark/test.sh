@@ -1,24 +1,48 @@
 #!/bin/bash
 
+# usage: test.sh [benchmark] [folder] [text|csv|json] [output folder]
+# text goes to compared.dat, csv to compared.csv and json to compared.json (JSON Lines), written to
+# the output folder, which defaults to folder
+
 base_folder="resources"
 
 
 current_folder=${2:-./}
+format=${3:-text}
+output_folder=${4:-${current_folder}}
+
+case ${format} in
+    text) output=compared.dat ;;
+    csv)  output=compared.csv ;;
+    json) output=compared.json ;;
+    *)    echo "Unknown format ${format}" >&2; exit 1 ;;
+esac
 
-exec 3>${current_folder}/compared.dat
+exec 3>${output_folder}/${output}
 exec 2>&3
 exec 1>&3
 
+first=true
 for file in ${current_folder}/${base_folder}/test*.dat; do
 
-    echo -e "Testing ${file} ..."
+    if [ ${format} == text ]; then
+        echo -e "Testing ${file} ..."
+    fi
 
     # Check if an argument to executable location has been passed to the program
     if [ -z "$1" ]; then
-        bin/benchmark < $file
+        benchmark=bin/benchmark
+    else
+        benchmark=$1
+    fi
+
+    # every csv run starts with the header, keep only the first one
+    if [ ${format} == csv ] && [ ${first} == false ]; then
+        ${benchmark} --format=${format} --workload=$(basename ${file}) < $file | tail -n +2
     else
-        $1 < $file
+        ${benchmark} --format=${format} --workload=$(basename ${file}) < $file
     fi
+    first=false
 done
 
-exit 0
\ No newline at end of file
+exit 0
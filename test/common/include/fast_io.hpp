@@ -0,0 +1,236 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// buffered reading and writing of whitespace separated integers
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace red
+{
+namespace io
+{
+
+// Input of a file descriptor. Regular files are mapped, anything else (pipes, terminals) is read
+// in large chunks on demand, so commands can be processed while the input is still coming.
+class input_buffer
+{
+    int m_fd;
+    bool m_eof                = false;
+    const char *m_curr        = nullptr;
+    const char *m_end         = nullptr;
+    void *m_mapped            = nullptr;
+    std::size_t m_mapped_size = 0;
+    std::vector<char> m_storage;
+
+    static constexpr std::size_t chunk_size = std::size_t {1} << 20;
+
+    static bool is_space (char c) { return static_cast<unsigned char> (c) <= ' '; }
+
+    // Appends the next chunk of input to the unconsumed part, false at the end of input. Spans
+    // and words returned earlier become invalid.
+    bool fill ()
+    {
+        if ( m_eof )
+            return false;
+
+        auto remaining = static_cast<std::size_t> (m_end - m_curr);
+        if ( remaining )
+            std::memmove (m_storage.data (), m_curr, remaining);
+        if ( m_storage.size () < remaining + chunk_size )
+            m_storage.resize (remaining + chunk_size);
+
+        ssize_t n_read {};
+        while ( (n_read = ::read (m_fd, m_storage.data () + remaining,
+                                  m_storage.size () - remaining)) < 0 )
+            if ( errno != EINTR )
+                throw std::system_error (errno, std::generic_category (), "input_buffer");
+        m_eof  = !n_read;
+        m_curr = m_storage.data ();
+        m_end  = m_curr + remaining + static_cast<std::size_t> (n_read);
+        return n_read;
+    }
+
+  public:
+    explicit input_buffer (int fd = STDIN_FILENO) : m_fd {fd}
+    {
+        struct stat st {};
+        if ( !fstat (fd, &st) && S_ISREG (st.st_mode) && st.st_size > 0 )
+        {
+            m_mapped_size = static_cast<std::size_t> (st.st_size);
+            m_mapped      = mmap (nullptr, m_mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if ( m_mapped != MAP_FAILED )
+            {
+                madvise (m_mapped, m_mapped_size, MADV_SEQUENTIAL);
+                m_curr = static_cast<const char *> (m_mapped);
+                m_end  = m_curr + m_mapped_size;
+                m_eof  = true;
+                return;
+            }
+            m_mapped = nullptr;
+        }
+    }
+
+    input_buffer (const input_buffer &)            = delete;
+    input_buffer &operator= (const input_buffer &) = delete;
+
+    ~input_buffer ()
+    {
+        if ( m_mapped )
+            munmap (m_mapped, m_mapped_size);
+    }
+
+    // reads everything up to the end of input, after this data () returns the whole rest
+    void read_all ()
+    {
+        while ( fill () )
+            ;
+    }
+
+    // the part of the input that is read but not consumed yet
+    std::span<const char> data () const { return {m_curr, m_end}; }
+
+    // true if the next token can be read without waiting for more input
+    bool has_token () const
+    {
+        if ( m_eof )
+            return true;
+        auto first = std::find_if_not (m_curr, m_end, is_space);
+        return std::find_if (first, m_end, is_space) != m_end;
+    }
+
+    // Skips whitespace and makes sure the next token is read completely, false if nothing is
+    // left.
+    bool skip_spaces ()
+    {
+        for ( ;; )
+        {
+            while ( m_curr != m_end && is_space (*m_curr) )
+                ++m_curr;
+            if ( m_curr != m_end || !fill () )
+                break;
+        }
+        while ( !m_eof && std::find_if (m_curr, m_end, is_space) == m_end )
+            fill ();
+        return m_curr != m_end;
+    }
+
+    // the next whitespace separated token, valid until the next read
+    std::string_view read_word ()
+    {
+        if ( !skip_spaces () )
+            throw std::runtime_error ("Unexpected end of input");
+        auto first = m_curr;
+        m_curr     = std::find_if (m_curr, m_end, is_space);
+        return {first, m_curr};
+    }
+
+    // Reads the next whitespace separated integer, throws std::runtime_error if the input is
+    // over, the next token is not a number or the number does not fit into Int.
+    template <std::integral Int> Int read ()
+    {
+        if ( !skip_spaces () )
+            throw std::runtime_error ("Unexpected end of input");
+
+        Int res {};
+        auto [last, err] = std::from_chars (m_curr, m_end, res);
+        if ( err == std::errc::result_out_of_range )
+            throw std::runtime_error ("Integer out of range");
+        if ( err != std::errc {} )
+            throw std::runtime_error ("Integer expected");
+        m_curr = last;
+        return res;
+    }
+};
+
+// Output collected in a large buffer and written to the file descriptor when it fills up, on
+// flush () and on destruction.
+class output_buffer
+{
+    int m_fd;
+    std::vector<char> m_buf;
+    std::size_t m_size = 0;
+
+    static constexpr std::size_t buffer_size = std::size_t {1} << 20;
+    static constexpr std::size_t max_number  = 24;
+
+  public:
+    explicit output_buffer (int fd = STDOUT_FILENO) : m_fd {fd}, m_buf (buffer_size) {}
+
+    output_buffer (const output_buffer &)            = delete;
+    output_buffer &operator= (const output_buffer &) = delete;
+
+    ~output_buffer ()
+    {
+        try
+        {
+            flush ();
+        }
+        catch ( ... )
+        {
+        }
+    }
+
+    template <std::integral Int> output_buffer &operator<< (Int value)
+    {
+        if ( m_size + max_number > m_buf.size () )
+            flush ();
+        auto first = m_buf.data () + m_size;
+        auto last  = std::to_chars (first, first + max_number, value).ptr;
+        m_size += static_cast<std::size_t> (last - first);
+        return *this;
+    }
+
+    output_buffer &operator<< (char c)
+    {
+        if ( m_size == m_buf.size () )
+            flush ();
+        m_buf[m_size++] = c;
+        return *this;
+    }
+
+    output_buffer &operator<< (std::string_view str)
+    {
+        for ( auto c : str )
+            *this << c;
+        return *this;
+    }
+
+    void flush ()
+    {
+        for ( std::size_t written = 0; written < m_size; )
+        {
+            auto n_written = ::write (m_fd, m_buf.data () + written, m_size - written);
+            if ( n_written < 0 && errno == EINTR )
+                continue;
+            if ( n_written < 0 )
+                throw std::system_error (errno, std::generic_category (), "output_buffer");
+            written += static_cast<std::size_t> (n_written);
+        }
+        m_size = 0;
+    }
+};
+
+}   // namespace io
+}   // namespace red
@@ -0,0 +1,224 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// range count workloads in the text and binary formats
+
+#pragma once
+
+#include "fast_io.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace red
+{
+namespace io
+{
+
+// Text format: number of elements, the elements, number of queries, then the query bounds in
+// pairs, all separated by whitespace. The bounds of a query may come in any order.
+//
+// Binary format (version 1), all numbers little-endian:
+//     workload_header
+//     elements: n_elements int32 or, with workload_compressed, elements_bytes of LEB128 encoded
+//               deltas of the sorted elements (the first one zigzag encoded)
+//     padding up to a multiple of 4 bytes
+//     queries:  n_queries range_query with lo <= hi
+// Both arrays are 4-byte aligned, so a mapped file is used in place. Only compressed elements are
+// decoded.
+
+struct range_query
+{
+    std::int32_t lo;
+    std::int32_t hi;
+};
+
+struct workload_header
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    std::uint64_t n_elements;
+    std::uint64_t n_queries;
+    std::uint64_t elements_bytes;
+};
+
+inline constexpr char workload_magic[4]            = {'S', 'P', 'L', 'W'};
+inline constexpr std::uint32_t workload_version    = 1;
+inline constexpr std::uint32_t workload_compressed = 1;
+
+static_assert (sizeof (workload_header) == 40);
+static_assert (sizeof (range_query) == 8 && alignof (range_query) == 4);
+static_assert (std::endian::native == std::endian::little,
+               "binary workloads are used in place and need a little-endian host");
+
+inline bool is_binary_workload (std::span<const char> data)
+{
+    return data.size () >= sizeof (workload_header) &&
+           !std::memcmp (data.data (), workload_magic, sizeof (workload_magic));
+}
+
+// Elements and queries of a workload. Binary input is referenced in place, so the input_buffer
+// must outlive the workload.
+class workload
+{
+    std::span<const std::int32_t> m_elements;
+    std::span<const range_query> m_queries;
+    std::vector<std::int32_t> m_elements_storage;
+    std::vector<range_query> m_queries_storage;
+
+  public:
+    explicit workload (input_buffer &in)
+    {
+        in.read_all ();
+        if ( is_binary_workload (in.data ()) )
+            load_binary (in.data ());
+        else
+            load_text (in);
+    }
+
+    std::span<const std::int32_t> elements () const { return m_elements; }
+    std::span<const range_query> queries () const { return m_queries; }
+
+  private:
+    void load_text (input_buffer &in)
+    {
+        auto n_elements = in.read<unsigned> ();
+        m_elements_storage.reserve (n_elements);
+        for ( ; n_elements > 0; --n_elements )
+            m_elements_storage.push_back (in.read<std::int32_t> ());
+
+        auto n_queries = in.read<unsigned> ();
+        m_queries_storage.reserve (n_queries);
+        for ( ; n_queries > 0; --n_queries )
+        {
+            auto bound1 = in.read<std::int32_t> ();
+            auto bound2 = in.read<std::int32_t> ();
+            m_queries_storage.push_back ({std::min (bound1, bound2), std::max (bound1, bound2)});
+        }
+        m_elements = m_elements_storage;
+        m_queries  = m_queries_storage;
+    }
+
+    void load_binary (std::span<const char> data)
+    {
+        workload_header header;
+        std::memcpy (&header, data.data (), sizeof (header));
+        if ( header.version != workload_version )
+            throw std::runtime_error ("Unsupported binary workload version");
+
+        auto elements_offset = sizeof (header);
+        auto queries_offset  = (elements_offset + header.elements_bytes + 3) / 4 * 4;
+        if ( header.elements_bytes > data.size () - elements_offset ||
+             queries_offset > data.size () ||
+             header.n_queries > (data.size () - queries_offset) / sizeof (range_query) )
+            throw std::runtime_error ("Truncated binary workload");
+
+        auto elements = data.subspan (elements_offset, header.elements_bytes);
+        if ( header.flags & workload_compressed )
+        {
+            m_elements_storage = decode_elements (elements, header.n_elements);
+            m_elements         = m_elements_storage;
+        }
+        else
+        {
+            // the division keeps n_elements * 4 from wrapping around
+            if ( header.n_elements > header.elements_bytes / sizeof (std::int32_t) ||
+                 header.elements_bytes != header.n_elements * sizeof (std::int32_t) )
+                throw std::runtime_error ("Corrupted binary workload");
+            m_elements = {reinterpret_cast<const std::int32_t *> (elements.data ()),
+                          header.n_elements};
+        }
+        m_queries = {reinterpret_cast<const range_query *> (data.data () + queries_offset),
+                     header.n_queries};
+    }
+
+    static std::vector<std::int32_t> decode_elements (std::span<const char> bytes,
+                                                      std::uint64_t n_elements)
+    {
+        // every delta takes at least one byte, so a larger count can not be right
+        if ( n_elements > bytes.size () )
+            throw std::runtime_error ("Corrupted binary workload");
+        std::vector<std::int32_t> res;
+        res.reserve (n_elements);
+        auto curr = bytes.begin ();
+        std::uint32_t value {};
+        for ( std::uint64_t i = 0; i < n_elements; ++i )
+        {
+            std::uint32_t delta = 0;
+            for ( unsigned shift = 0;; shift += 7 )
+            {
+                if ( curr == bytes.end () || shift > 28 )
+                    throw std::runtime_error ("Corrupted binary workload");
+                auto byte = static_cast<std::uint8_t> (*curr++);
+                delta |= static_cast<std::uint32_t> (byte & 0x7f) << shift;
+                if ( !(byte & 0x80) )
+                    break;
+            }
+            // the first value is zigzag encoded, the rest are non-negative deltas
+            value = (i ? value + delta : (delta >> 1) ^ (0u - (delta & 1)));
+            res.push_back (static_cast<std::int32_t> (value));
+        }
+        return res;
+    }
+};
+
+// writes a workload in the binary format, compression sorts the elements
+inline std::vector<char> encode_workload (std::span<const std::int32_t> elements,
+                                          std::span<const range_query> queries, bool compress)
+{
+    std::vector<char> compressed;
+    if ( compress )
+    {
+        std::vector<std::int32_t> sorted (elements.begin (), elements.end ());
+        std::sort (sorted.begin (), sorted.end ());
+        std::uint32_t prev {};
+        for ( std::size_t i = 0; i < sorted.size (); ++i )
+        {
+            auto value = static_cast<std::uint32_t> (sorted[i]);
+            auto delta = (i ? value - prev : (value << 1) ^ (0u - (value >> 31)));
+            for ( ; delta >= 0x80; delta >>= 7 )
+                compressed.push_back (static_cast<char> (delta | 0x80));
+            compressed.push_back (static_cast<char> (delta));
+            prev = value;
+        }
+    }
+
+    workload_header header {};
+    std::memcpy (header.magic, workload_magic, sizeof (workload_magic));
+    header.version        = workload_version;
+    header.flags          = (compress ? workload_compressed : 0);
+    header.n_elements     = elements.size ();
+    header.n_queries      = queries.size ();
+    header.elements_bytes = (compress ? compressed.size () : elements.size_bytes ());
+
+    auto queries_offset = (sizeof (header) + header.elements_bytes + 3) / 4 * 4;
+    std::vector<char> res (queries_offset + queries.size_bytes ());
+    auto write_at = [&res] (std::size_t offset, const void *data, std::size_t size) {
+        if ( size )
+            std::memcpy (res.data () + offset, data, size);
+    };
+    write_at (0, &header, sizeof (header));
+    if ( compress )
+        write_at (sizeof (header), compressed.data (), compressed.size ());
+    else
+        write_at (sizeof (header), elements.data (), elements.size_bytes ());
+    write_at (queries_offset, queries.data (), queries.size_bytes ());
+    return res;
+}
+
+}   // namespace io
+}   // namespace red
@@ -0,0 +1,52 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// converts a text range count workload into the binary format, see workload.hpp
+
+#include "fast_io.hpp"
+#include "workload.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+
+int main (int argc, char **argv)
+try
+{
+    bool compress = (argc == 4 && !std::strcmp (argv[1], "-c"));
+    if ( argc != 3 + compress )
+    {
+        std::cerr << "usage: " << argv[0] << " [-c] <text workload> <binary workload>\n"
+                  << "\t-c  compress the elements\n";
+        return 1;
+    }
+
+    auto fd = open (argv[1 + compress], O_RDONLY);
+    if ( fd < 0 )
+        throw std::runtime_error (std::string ("Cannot open ") + argv[1 + compress]);
+    red::io::input_buffer in {fd};
+    // only a mapped regular file is read by now, pipes and empty files are read by the workload
+    red::io::workload load {in};
+    close (fd);
+    auto bytes = red::io::encode_workload (load.elements (), load.queries (), compress);
+
+    std::ofstream out {argv[2 + compress], std::ios::binary};
+    out.write (bytes.data (), static_cast<std::streamsize> (bytes.size ()));
+    if ( !out )
+        throw std::runtime_error (std::string ("Cannot write ") + argv[2 + compress]);
+}
+catch ( std::exception &e )
+{
+    std::cerr << "convert_workload: " << e.what () << std::endl;
+    return 1;
+}
@@ -0,0 +1,173 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// key sequences for the microbenchmarks
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace red
+{
+namespace microbench
+{
+
+enum class distribution
+{
+    uniform,
+    sequential,
+    reverse,
+    zipf,
+    working_set,
+};
+
+inline constexpr std::array distributions = {distribution::uniform, distribution::sequential,
+                                             distribution::reverse, distribution::zipf,
+                                             distribution::working_set};
+
+inline std::string_view name (distribution dist)
+{
+    switch ( dist )
+    {
+    case distribution::uniform:
+        return "uniform";
+    case distribution::sequential:
+        return "sequential";
+    case distribution::reverse:
+        return "reverse";
+    case distribution::zipf:
+        return "zipf";
+    case distribution::working_set:
+        return "working_set";
+    }
+    return "";
+}
+
+// Zipf distributed ranks in [0, n) with the constant-time method of Gray et al. "Quickly
+// generating billion-record synthetic databases". Construction is O(n).
+class zipf_generator
+{
+    double m_n, m_theta, m_alpha, m_zetan, m_eta;
+
+    static double zeta (std::size_t n, double theta)
+    {
+        double res = 0;
+        for ( std::size_t i = 1; i <= n; ++i )
+            res += 1 / std::pow (static_cast<double> (i), theta);
+        return res;
+    }
+
+  public:
+    explicit zipf_generator (std::size_t n, double theta = 0.99)
+        : m_n {static_cast<double> (n)}, m_theta {theta}, m_alpha {1 / (1 - theta)},
+          m_zetan {zeta (n, theta)},
+          m_eta {(1 - std::pow (2 / m_n, 1 - theta)) / (1 - zeta (2, theta) / m_zetan)}
+    {
+    }
+
+    template <typename Gen> std::size_t operator() (Gen &gen)
+    {
+        auto u  = std::uniform_real_distribution<double> {0, 1}(gen);
+        auto uz = u * m_zetan;
+        if ( uz < 1 )
+            return 0;
+        if ( uz < 1 + std::pow (0.5, m_theta) )
+            return 1;
+        auto res = static_cast<std::size_t> (m_n * std::pow (m_eta * u - m_eta + 1, m_alpha));
+        return std::min (res, static_cast<std::size_t> (m_n) - 1);
+    }
+};
+
+// count keys in [0, n) accessed in the given pattern. Zipf ranks are scattered over the key
+// space, the working set pattern sends 90% of the accesses to a window of 1% of the keys that
+// moves 16 times over the sequence.
+inline std::vector<int> access_sequence (distribution dist, std::size_t n, std::size_t count,
+                                         unsigned seed = 42)
+{
+    std::mt19937_64 gen {seed};
+    std::uniform_int_distribution<std::size_t> any_key {0, n - 1};
+    std::vector<int> res (count);
+
+    switch ( dist )
+    {
+    case distribution::uniform:
+        for ( auto &key : res )
+            key = static_cast<int> (any_key (gen));
+        break;
+    case distribution::sequential:
+        for ( std::size_t i = 0; i < count; ++i )
+            res[i] = static_cast<int> (i % n);
+        break;
+    case distribution::reverse:
+        for ( std::size_t i = 0; i < count; ++i )
+            res[i] = static_cast<int> (n - 1 - i % n);
+        break;
+    case distribution::zipf:
+    {
+        zipf_generator zipf {n};
+        // popular ranks are scattered over the key space, otherwise zipf is just a skewed
+        // sequential pattern
+        std::vector<int> perm (n);
+        std::iota (perm.begin (), perm.end (), 0);
+        std::shuffle (perm.begin (), perm.end (), gen);
+        for ( auto &key : res )
+            key = perm[zipf (gen)];
+        break;
+    }
+    case distribution::working_set:
+    {
+        auto window = std::max<std::size_t> (n / 100, 1);
+        auto period = std::max<std::size_t> (count / 16, 1);
+        std::uniform_int_distribution<std::size_t> in_window {0, window - 1};
+        std::bernoulli_distribution hot {0.9};
+        std::size_t window_start = 0;
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            if ( i % period == 0 )
+                window_start = any_key (gen) / window * window;
+            auto key = (hot (gen) ? window_start + in_window (gen) : any_key (gen));
+            res[i]   = static_cast<int> (std::min (key, n - 1));
+        }
+        break;
+    }
+    }
+    return res;
+}
+
+// Permutation of [0, n) for inserting or erasing every key once: keys in the order of their
+// first appearance in the access sequence, the ones that never appeared shuffled at the end.
+inline std::vector<int> insert_order (distribution dist, std::size_t n, unsigned seed = 42)
+{
+    std::vector<int> res;
+    res.reserve (n);
+    std::vector<bool> seen (n);
+    for ( auto key : access_sequence (dist, n, n, seed) )
+        if ( !seen[key] )
+        {
+            seen[key] = true;
+            res.push_back (key);
+        }
+
+    auto tail = res.size ();
+    for ( std::size_t key = 0; key < n; ++key )
+        if ( !seen[key] )
+            res.push_back (static_cast<int> (key));
+    std::shuffle (res.begin () + tail, res.end (), std::mt19937_64 {seed + 1});
+    return res;
+}
+
+}   // namespace microbench
+}   // namespace red
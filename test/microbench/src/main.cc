@@ -0,0 +1,376 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <alex.rom23@mail.ru> wrote this file.  As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.   Alex Romanov
+ * ----------------------------------------------------------------------------
+ */
+
+// Every benchmark iteration is a single operation, so the reported time is ns/op. Benchmarks of
+// whole-set operations (iteration, copy, clear) also report the time per element.
+
+#include "balanced_order_set.hpp"
+#include "compact_splay_order_set.hpp"
+#include "key_distributions.hpp"
+#include "sharded_order_set.hpp"
+#include "splay_dynamic_order_set.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef MICROBENCH_MAX_SIZE
+#define MICROBENCH_MAX_SIZE 1000000
+#endif
+
+using splay_set = red::containers::splay_dynamic_order_set<int>;
+using top_down_splay_set =
+    red::containers::splay_dynamic_order_set<int, std::less<int>, red::containers::node_arena<int>,
+                                             red::containers::top_down_splay>;
+using compact_splay_set = red::containers::compact_splay_order_set<int>;
+
+template <typename Splay_t>
+using policy_splay_set =
+    red::containers::splay_dynamic_order_set<int, std::less<int>, red::containers::node_arena<int>,
+                                             Splay_t>;
+using semi_splay_set      = policy_splay_set<red::containers::semi_splay>;
+using threshold_splay_set = policy_splay_set<red::containers::depth_threshold_splay>;
+using random_splay_set    = policy_splay_set<red::containers::randomized_splay>;
+
+using treap_set = red::containers::treap_order_set<int>;
+using avl_set   = red::containers::avl_order_set<int>;
+using rb_set    = red::containers::rb_order_set<int>;
+
+using sharded_splay_set = red::containers::sharded_order_set<int>;
+
+using red::microbench::distribution;
+
+namespace
+{
+
+// lookups cycle through a fixed number of precomputed keys
+constexpr std::size_t n_lookups = std::size_t {1} << 20;
+
+// The set holds the even numbers 0, 2, ..., 2n - 2, so lookups of odd numbers miss and
+// lower_bound does not degenerate into find.
+std::vector<int> even_keys (std::size_t n)
+{
+    std::vector<int> res (n);
+    for ( std::size_t i = 0; i < n; ++i )
+        res[i] = static_cast<int> (2 * i);
+    return res;
+}
+
+std::vector<int> lookup_keys (distribution dist, std::size_t n, int offset)
+{
+    auto res = red::microbench::access_sequence (dist, n, n_lookups);
+    for ( auto &key : res )
+        key = 2 * key + offset;
+    return res;
+}
+
+void set_per_element (benchmark::State &state, std::size_t n)
+{
+    state.counters["per_element"] = benchmark::Counter (
+        static_cast<double> (state.iterations () * n),
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+template <typename Set_t> void bm_insert (benchmark::State &state, distribution dist)
+{
+    auto n     = static_cast<std::size_t> (state.range (0));
+    auto order = red::microbench::insert_order (dist, n);
+    Set_t set;
+    std::size_t i = 0;
+    for ( auto _ : state )
+    {
+        set.insert (2 * order[i]);
+        if ( ++i == n )
+        {
+            state.PauseTiming ();
+            set.clear ();
+            i = 0;
+            state.ResumeTiming ();
+        }
+    }
+}
+
+template <typename Set_t> void bm_erase_key (benchmark::State &state, distribution dist)
+{
+    auto n     = static_cast<std::size_t> (state.range (0));
+    auto order = red::microbench::insert_order (dist, n);
+    auto keys  = even_keys (n);
+    Set_t set (keys.begin (), keys.end ());
+    std::size_t i = 0;
+    for ( auto _ : state )
+    {
+        set.erase (2 * order[i]);
+        if ( ++i == n )
+        {
+            state.PauseTiming ();
+            set.assign (keys.begin (), keys.end ());
+            i = 0;
+            state.ResumeTiming ();
+        }
+    }
+}
+
+template <typename Set_t> void bm_erase_iterator (benchmark::State &state, distribution dist)
+{
+    auto n     = static_cast<std::size_t> (state.range (0));
+    auto order = red::microbench::insert_order (dist, n);
+    auto keys  = even_keys (n);
+    Set_t set;
+    std::vector<decltype (set.find (0))> to_erase;
+    auto refill = [&] {
+        set.assign (keys.begin (), keys.end ());
+        to_erase.clear ();
+        for ( auto key : order )
+            to_erase.push_back (set.find (2 * key));
+    };
+
+    refill ();
+    std::size_t i = 0;
+    for ( auto _ : state )
+    {
+        set.erase (to_erase[i]);
+        if ( ++i == n )
+        {
+            state.PauseTiming ();
+            refill ();
+            i = 0;
+            state.ResumeTiming ();
+        }
+    }
+}
+
+template <typename Set_t, typename F>
+void bm_lookup (benchmark::State &state, distribution dist, int offset, F op)
+{
+    auto n       = static_cast<std::size_t> (state.range (0));
+    auto keys    = even_keys (n);
+    auto lookups = lookup_keys (dist, n, offset);
+    Set_t set (keys.begin (), keys.end ());
+    std::size_t i = 0;
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize (op (set, lookups[i]));
+        i = (i + 1) % n_lookups;
+    }
+}
+
+template <typename Set_t> void bm_find (benchmark::State &state, distribution dist)
+{
+    bm_lookup<Set_t> (state, dist, 0, [] (Set_t &set, int key) { return set.find (key); });
+}
+
+template <typename Set_t> void bm_lower_bound (benchmark::State &state, distribution dist)
+{
+    bm_lookup<Set_t> (state, dist, 1, [] (Set_t &set, int key) { return set.lower_bound (key); });
+}
+
+template <typename Set_t> void bm_get_number_less_then (benchmark::State &state, distribution dist)
+{
+    bm_lookup<Set_t> (state, dist, 1,
+                      [] (Set_t &set, int key) { return set.get_number_less_then (key); });
+}
+
+template <typename Set_t> void bm_os_select (benchmark::State &state, distribution dist)
+{
+    // keys are 2 * (rank - 1), so halving them gives the ranks in the same pattern
+    bm_lookup<Set_t> (state, dist, 0,
+                      [] (Set_t &set, int key) { return set.os_select (key / 2 + 1); });
+}
+
+template <typename Set_t> void bm_get_rank_of (benchmark::State &state, distribution dist)
+{
+    auto n       = static_cast<std::size_t> (state.range (0));
+    auto keys    = even_keys (n);
+    auto lookups = lookup_keys (dist, n, 0);
+    Set_t set (keys.begin (), keys.end ());
+    std::vector<decltype (set.find (0))> iterators;
+    iterators.reserve (n_lookups);
+    for ( auto key : lookups )
+        iterators.push_back (set.find (key));
+
+    std::size_t i = 0;
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize (set.get_rank_of (iterators[i]));
+        i = (i + 1) % n_lookups;
+    }
+}
+
+template <typename Set_t> void bm_iteration (benchmark::State &state, distribution)
+{
+    auto n    = static_cast<std::size_t> (state.range (0));
+    auto keys = even_keys (n);
+    const Set_t set (keys.begin (), keys.end ());
+    for ( auto _ : state )
+        benchmark::DoNotOptimize (std::accumulate (set.begin (), set.end (), 0L));
+    set_per_element (state, n);
+}
+
+// The copy and clear benchmarks build the set by inserting in the order of the distribution,
+// so the shape of the tree depends on it.
+template <typename Set_t> Set_t build_by_insertion (distribution dist, std::size_t n)
+{
+    Set_t set;
+    for ( auto key : red::microbench::insert_order (dist, n) )
+        set.insert (2 * key);
+    return set;
+}
+
+template <typename Set_t> void bm_copy (benchmark::State &state, distribution dist)
+{
+    auto n         = static_cast<std::size_t> (state.range (0));
+    const auto set = build_by_insertion<Set_t> (dist, n);
+    for ( auto _ : state )
+    {
+        Set_t copy {set};
+        benchmark::DoNotOptimize (copy);
+    }
+    set_per_element (state, n);
+}
+
+template <typename Set_t> void bm_clear (benchmark::State &state, distribution dist)
+{
+    auto n         = static_cast<std::size_t> (state.range (0));
+    const auto set = build_by_insertion<Set_t> (dist, n);
+    for ( auto _ : state )
+    {
+        state.PauseTiming ();
+        Set_t copy {set};
+        state.ResumeTiming ();
+        copy.clear ();
+        benchmark::ClobberMemory ();
+    }
+    set_per_element (state, n);
+}
+
+template <typename Set_t> void register_set (std::string_view set_name)
+{
+    using bm_function = void (*) (benchmark::State &, distribution);
+    const std::pair<std::string_view, bm_function> operations[] = {
+        {"insert", bm_insert<Set_t>},
+        {"erase_key", bm_erase_key<Set_t>},
+        {"erase_iterator", bm_erase_iterator<Set_t>},
+        {"find", bm_find<Set_t>},
+        {"lower_bound", bm_lower_bound<Set_t>},
+        {"os_select", bm_os_select<Set_t>},
+        {"get_rank_of", bm_get_rank_of<Set_t>},
+        {"get_number_less_then", bm_get_number_less_then<Set_t>},
+        {"iteration", bm_iteration<Set_t>},
+        {"copy", bm_copy<Set_t>},
+        {"clear", bm_clear<Set_t>},
+    };
+
+    for ( auto [op_name, function] : operations )
+        for ( auto dist : red::microbench::distributions )
+        {
+            auto name = std::string {set_name} + '/' + std::string {op_name} + '/' +
+                        std::string {red::microbench::name (dist)};
+            auto *bm  = benchmark::RegisterBenchmark (name.c_str (), function, dist);
+            for ( long n = 1000; n <= MICROBENCH_MAX_SIZE; n *= 10 )
+                bm->Arg (n);
+        }
+}
+
+// the baseline for the concurrent ingest: one splay set behind one mutex
+class locked_splay_set
+{
+    std::mutex m_mutex;
+    splay_set m_set;
+
+  public:
+    explicit locked_splay_set (std::size_t) {}
+
+    void insert (int key)
+    {
+        std::lock_guard lock {m_mutex};
+        m_set.insert (key);
+    }
+};
+
+// number of shards of the sharded set in the concurrent ingest
+constexpr std::size_t n_ingest_shards = 32;
+
+// Every iteration fills an empty set with n keys from state.range (0) threads, each thread
+// inserting its own interleaved part of one uniform permutation. Reports the time per key.
+template <typename Set_t> void bm_concurrent_ingest (benchmark::State &state)
+{
+    auto n_threads = static_cast<std::size_t> (state.range (0));
+    auto n         = static_cast<std::size_t> (state.range (1));
+    auto order     = red::microbench::insert_order (distribution::uniform, n);
+    for ( auto _ : state )
+    {
+        Set_t set {n_ingest_shards};
+        std::vector<std::thread> writers;
+        for ( std::size_t t = 0; t < n_threads; ++t )
+            writers.emplace_back ([&set, &order, t, n_threads] {
+                for ( auto i = t; i < order.size (); i += n_threads )
+                    set.insert (order[i]);
+            });
+        for ( auto &writer : writers )
+            writer.join ();
+    }
+    set_per_element (state, n);
+}
+
+template <typename Set_t> void register_concurrent_ingest (std::string_view set_name)
+{
+    auto name = "concurrent_ingest/" + std::string {set_name};
+    auto *bm  = benchmark::RegisterBenchmark (name.c_str (), bm_concurrent_ingest<Set_t>);
+    bm->ArgNames ({"threads", ""})->UseRealTime ()->Unit (benchmark::kMillisecond);
+    for ( long n_threads = 1; n_threads <= 32; n_threads *= 2 )
+        for ( long n = 1000; n <= MICROBENCH_MAX_SIZE; n *= 10 )
+            bm->Args ({n_threads, n});
+}
+
+}   // namespace
+
+// Runs 5 repetitions of every benchmark and reports only the mean, median, stddev and cv unless
+// the command line says otherwise.
+int main (int argc, char **argv)
+{
+    register_set<splay_set> ("splay");
+    register_set<top_down_splay_set> ("top_down_splay");
+    register_set<compact_splay_set> ("compact_splay");
+    register_set<semi_splay_set> ("semi_splay");
+    register_set<threshold_splay_set> ("depth_threshold_splay");
+    register_set<random_splay_set> ("randomized_splay");
+    register_set<treap_set> ("treap");
+    register_set<avl_set> ("avl");
+    register_set<rb_set> ("rb");
+    register_concurrent_ingest<locked_splay_set> ("locked_splay");
+    register_concurrent_ingest<sharded_splay_set> ("sharded_splay");
+
+    std::vector<char *> args (argv, argv + argc);
+    auto has_flag = [&] (std::string_view flag) {
+        return std::any_of (args.begin (), args.end (), [flag] (std::string_view arg) {
+            return arg.starts_with (flag);
+        });
+    };
+    std::string repetitions = "--benchmark_repetitions=5";
+    std::string aggregates  = "--benchmark_report_aggregates_only=true";
+    if ( !has_flag ("--benchmark_repetitions") )
+        args.push_back (repetitions.data ());
+    if ( !has_flag ("--benchmark_report_aggregates_only") &&
+         !has_flag ("--benchmark_display_aggregates_only") )
+        args.push_back (aggregates.data ());
+
+    auto n_args = static_cast<int> (args.size ());
+    benchmark::Initialize (&n_args, args.data ());
+    if ( benchmark::ReportUnrecognizedArguments (n_args, args.data ()) )
+        return 1;
+    benchmark::RunSpecifiedBenchmarks ();
+    benchmark::Shutdown ();
+}
@@ -1,40 +1,95 @@
+#include "fast_io.hpp"
 #include "splay_dynamic_order_set.hpp"
+#include "workload.hpp"
 
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
-int main ()
+using splay_set = red::containers::splay_dynamic_order_set<int>;
+
+// Range count workload: the whole input is loaded, then all the queries are answered at once.
+void run_queries (red::io::input_buffer &in, red::io::output_buffer &out)
 {
-    red::containers::splay_dynamic_order_set<int> set {};
+    red::io::workload load {in};
+
+    auto elements = load.elements ();
+    splay_set set (elements.begin (), elements.end ());
 
-    unsigned n_elems {};
-    std::cin >> n_elems;
-    assert (std::cin.good ());
+    for ( auto count : set.count_in_ranges (load.queries ()) )
+        out << count << ' ';
+}
 
-    for ( ; n_elems > 0; --n_elems )
+// Commands applied to the set as they come:
+//     insert k, erase k  - no output, inserting a present key or erasing a missing one is a no-op
+//     count lo hi        - number of elements in [lo, hi]
+//     select r           - element of rank r (starting with 1) or "none"
+//     rank k             - 1 + number of elements less than k
+// Answers are separated by spaces and flushed whenever the next command has not arrived yet.
+void run_stream (red::io::input_buffer &in, red::io::output_buffer &out)
+{
+    splay_set set {};
+    for ( ;; )
     {
-        int key;
-        std::cin >> key;
-        assert (std::cin.good ());
-        set.insert (key);
-    }
+        if ( !in.has_token () )
+            out.flush ();
+        if ( !in.skip_spaces () )
+            break;
 
-    unsigned n_requests {};
-    std::cin >> n_requests;
-    assert (std::cin.good ());
+        auto command = in.read_word ();
+        if ( command == "insert" )
+        {
+            auto key = in.read<int> ();
+            if ( set.find (key) == set.end () )
+                set.insert (key);
+        }
+        else if ( command == "erase" )
+        {
+            auto key = in.read<int> ();
+            if ( auto found = set.find (key); found != set.end () )
+                set.erase (found);
+        }
+        else if ( command == "count" )
+        {
+            auto lo = in.read<int> ();
+            auto hi = in.read<int> ();
+            out << set.count_in_range (lo, hi) << ' ';
+        }
+        else if ( command == "select" )
+        {
+            auto found = set.os_select (in.read<std::size_t> ());
+            if ( found == set.end () )
+                out << "none ";
+            else
+                out << *found << ' ';
+        }
+        else if ( command == "rank" )
+            out << set.count_less (in.read<int> ()) + 1 << ' ';
+        else
+            throw std::runtime_error ("Unknown command " + std::string (command));
+    }
+}
 
-    for ( ; n_requests > 0; --n_requests )
+int main (int argc, char **argv)
+try
+{
+    bool stream = (argc == 2 && !std::strcmp (argv[1], "--stream"));
+    if ( argc > 1 && !stream )
     {
-        int bound1 {}, bound2 {}, l_bound {}, r_bound {};
-        std::cin >> bound1 >> bound2;
-        assert (std::cin.good ());
-        l_bound = std::min (bound1, bound2);
-        r_bound = std::max (bound1, bound2);
-
-        auto it_l = set.lower_bound (l_bound);
-        auto it_r = set.upper_bound (r_bound);
-
-        auto l_rank = (it_l == set.end () ? 0 : set.get_rank_of (it_l));
-        auto r_rank = (it_r == set.end () ? 0 : set.get_rank_of (it_r));
-        std::cout << r_rank - l_rank << " ";
+        std::cerr << "usage: " << argv[0] << " [--stream]\n";
+        return 1;
     }
+
+    red::io::input_buffer in {};
+    red::io::output_buffer out {};
+    if ( stream )
+        run_stream (in, out);
+    else
+        run_queries (in, out);
+}
+catch ( std::exception &e )
+{
+    std::cerr << "queries: " << e.what () << std::endl;
+    return 1;
 }
@@ -8,20 +8,39 @@ reset=`tput sgr0`
 
 current_folder=${2:-./}
 passed=true
+temp_folder=$(mktemp -d)
+trap 'rm -rf ${temp_folder}' EXIT
 
 for file in ${current_folder}/${base_folder}/test*.dat; do
     echo -n "Testing ${green}${file}${reset} ... "
 
     # Check if an argument to executable location has been passed to the program
     if [ -z "$1" ]; then
-        bin/queries < $file > ${current_folder}/$base_folder/temp.dat
+        bin/queries < $file > ${temp_folder}/temp.dat
     else
-        $1 < $file > ${current_folder}/$base_folder/temp.dat
+        $1 < $file > ${temp_folder}/temp.dat
     fi
 
     # Compare inputs
 
-    if diff -Z ${file}.ans ${current_folder}/${base_folder}/temp.dat; then
+    if diff -Z ${file}.ans ${temp_folder}/temp.dat; then
+        echo "${green}Passed${reset}"
+    else
+        echo "${red}Failed${reset}"
+        passed=false
+    fi
+done
+
+for file in ${current_folder}/${base_folder}/stream*.dat; do
+    echo -n "Testing ${green}${file}${reset} (stream) ... "
+
+    if [ -z "$1" ]; then
+        bin/queries --stream < $file > ${temp_folder}/temp.dat
+    else
+        $1 --stream < $file > ${temp_folder}/temp.dat
+    fi
+
+    if diff -Z ${file}.ans ${temp_folder}/temp.dat; then
         echo "${green}Passed${reset}"
     else
         echo "${red}Failed${reset}"
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# converts every text test into the binary format (plain and compressed) and checks that queries
+# gives the same answers on it
+
+base_folder="resources"
+
+queries=$1
+converter=$2
+current_folder=${3:-./}
+passed=true
+temp_folder=$(mktemp -d)
+trap 'rm -rf ${temp_folder}' EXIT
+
+for file in ${current_folder}/${base_folder}/test*.dat; do
+    for flags in "" "-c"; do
+        echo -n "Testing ${file} (binary ${flags}) ... "
+        ${converter} ${flags} ${file} ${temp_folder}/test.bin || { passed=false; continue; }
+        ${queries} < ${temp_folder}/test.bin > ${temp_folder}/temp.dat
+
+        if diff -Z ${file}.ans ${temp_folder}/temp.dat > /dev/null; then
+            echo "Passed"
+        else
+            echo "Failed"
+            passed=false
+        fi
+    done
+done
+
+if ${passed}
+then
+    exit 0
+else
+    exit 1
+fi
@@ -9,6 +9,7 @@
 ##
 
 import argparse
+import bisect
 from cgi import test
 import os
 import json
@@ -59,6 +60,49 @@ def generate_random_test (config: dict):
 
     return [test_str, ans_str]
 
+def generate_stream_test (config: dict):
+    operations_n = np.random.default_rng().integers (
+        config['stream']['operations']['min'], config['stream']['operations']['max']
+    )
+    int_min = config['integers']['min']
+    int_max = config['integers']['max']
+
+    elements = []
+    test_lines = []
+    answers = []
+    for i in range (operations_n):
+        op = random.choices (['insert', 'erase', 'count', 'select', 'rank'], weights = [4, 2, 2, 1, 1])[0]
+        if (op == 'insert' or op == 'erase'):
+            # erase mostly the present keys so that the set does not stay empty
+            if (op == 'erase' and elements and random.random () < 0.8):
+                key = random.choice (elements)
+            else:
+                key = random.randint (int_min, int_max)
+            pos = bisect.bisect_left (elements, key)
+            present = pos < len (elements) and elements[pos] == key
+            if (op == 'insert' and not present):
+                elements.insert (pos, key)
+            elif (op == 'erase' and present):
+                elements.pop (pos)
+            test_lines.append ('{} {}'.format (op, key))
+        elif (op == 'count'):
+            l_bound = random.randint (int_min, int_max)
+            r_bound = random.randint (l_bound, int_max)
+            test_lines.append ('count {} {}'.format (l_bound, r_bound))
+            answers.append (bisect.bisect_right (elements, r_bound) - bisect.bisect_left (elements, l_bound))
+        elif (op == 'select'):
+            rank = random.randint (0, len (elements) + 1)
+            test_lines.append ('select {}'.format (rank))
+            answers.append (elements[rank - 1] if 1 <= rank <= len (elements) else 'none')
+        else:
+            key = random.randint (int_min, int_max)
+            test_lines.append ('rank {}'.format (key))
+            answers.append (bisect.bisect_left (elements, key) + 1)
+
+    test_str = '\n'.join (test_lines) + '\n'
+    ans_str = ''.join ('{} '.format (ans) for ans in answers)
+    return [test_str, ans_str]
+
 def generate_tests (config: dict):
     # Create output directory if it does not exists
     os.makedirs(config['output_path'], exist_ok=True)
@@ -67,6 +111,12 @@ def generate_tests (config: dict):
     for i in range (number):
         test = generate_random_test (config)
         save_test (config['output_path'], test[0], test[1], i)
+
+    # mixed insert/erase/count/select/rank commands for queries --stream
+    if ('stream' in config):
+        for i in range (config['stream']['number']):
+            test = generate_stream_test (config)
+            save_test (config['output_path'], test[0], test[1], i, 'stream{}.dat', 'stream{}.dat.ans')
     
 
 def main ():